@@ -0,0 +1,81 @@
+#include "analysis.hpp"
+
+#include <fstream>
+#include <stdexcept>
+
+#include "mapped_file.hpp"
+#include "stats.hpp"
+
+namespace {
+
+[[noreturn]] void noSuchTab(const std::string &path, int tabId) {
+  throw std::runtime_error("No tab " + std::to_string(tabId) + " in " + path);
+}
+
+TraceMeta readPack(const std::string &path, std::string_view data, const EventSink &sink,
+                   const TraceSelection &sel) {
+  PackReader pack(data);
+  if (pack.tabCount() == 0) throw std::runtime_error("Pack has no traces: " + path);
+  size_t tab = 0;
+  if (sel.tabId) {
+    tab = pack.findTab(*sel.tabId);
+    if (tab == pack.tabCount()) noSuchTab(path, *sel.tabId);
+  }
+  pack.read(tab, sink, sel.window);
+  return pack.meta(tab);
+}
+
+}  // namespace
+
+TraceMeta readTraceFile(const std::string &path, const EventSink &sink,
+                        const TraceSelection &sel) {
+  auto windowed = [&](const TraceEvent &ev) {
+    if (sel.window.contains(ev.tMs)) sink(ev);
+  };
+
+  // Regular files are mapped and scanned in place; anything else (pipes,
+  // /dev/stdin, empty files) goes through the stream parser.
+  Stats *stats = activeStats();
+  ReadTimer timer(stats);
+  TraceMeta meta;
+  MappedFile mapped;
+  if (mapped.open(path)) {
+    if (stats) stats->add(Counter::BytesRead, mapped.data().size());
+    if (isPack(mapped.data())) return readPack(path, mapped.data(), timer.wrap(sink), sel);
+    meta = readTraceBuffer(mapped.data(), timer.wrap(windowed));
+  } else {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("Failed to open trace: " + path);
+    meta = readTrace(in, timer.wrap(windowed));
+    // Pipes cannot report a position; their bytes go uncounted.
+    if (stats && in.tellg() > 0) stats->add(Counter::BytesRead, static_cast<uint64_t>(in.tellg()));
+  }
+  if (sel.tabId && meta.tabId != *sel.tabId) noSuchTab(path, *sel.tabId);
+  return meta;
+}
+
+AnalysisResult analyzeTraceFile(const std::string &path, const TraceSelection &sel) {
+  RuleEngine engine;
+  AnalysisResult result;
+  result.meta = readTraceFile(path, [&](const TraceEvent &ev) { engine.onEvent(ev); }, sel);
+  engine.finish();
+  result.findings = engine.takeFindings();
+  return result;
+}
+
+std::shared_ptr<const OpenPack> openPack(const std::string &path) {
+  auto pack = std::make_shared<OpenPack>();
+  if (!pack->file.open(path) || !isPack(pack->file.data())) return nullptr;
+  pack->reader = std::make_unique<PackReader>(pack->file.data());
+  return pack;
+}
+
+AnalysisResult analyzePackTab(const PackReader &pack, size_t tab) {
+  RuleEngine engine;
+  AnalysisResult result;
+  pack.read(tab, [&](const TraceEvent &ev) { engine.onEvent(ev); });
+  engine.finish();
+  result.meta = pack.meta(tab);
+  result.findings = engine.takeFindings();
+  return result;
+}
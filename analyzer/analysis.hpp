@@ -0,0 +1,48 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "mapped_file.hpp"
+#include "pack.hpp"
+#include "rules.hpp"
+#include "trace.hpp"
+
+struct AnalysisResult {
+  TraceMeta meta;
+  FindingSet findings;
+};
+
+// Which part of a trace file to analyze. A pack holds several tabs and
+// defaults to its first; a JSON trace holds one and fails if `tabId` names
+// another. The window filters events by tMs in either format.
+struct TraceSelection {
+  std::optional<int> tabId;
+  TimeWindow window;
+};
+
+// Streams the selected events of a JSON trace or a pack to `sink`. Regular
+// files are memory-mapped; packs are recognized by their magic. Throws
+// std::runtime_error with a user-facing message when the file cannot be
+// opened or parsed.
+TraceMeta readTraceFile(const std::string &path, const EventSink &sink,
+                        const TraceSelection &sel = {});
+
+// Reads and analyzes one trace file end to end with the built-in rules.
+// Throws like readTraceFile().
+AnalysisResult analyzeTraceFile(const std::string &path, const TraceSelection &sel = {});
+
+// A pack kept mapped while its tabs are analyzed, possibly on several threads.
+struct OpenPack {
+  MappedFile file;
+  std::unique_ptr<PackReader> reader;
+};
+
+// Maps `path` and opens it as a pack, or returns nullptr if it cannot be
+// mapped or is not a pack. Throws std::runtime_error on a malformed pack.
+std::shared_ptr<const OpenPack> openPack(const std::string &path);
+
+// Analyzes the tab at position `tab` of a pack with the built-in rules.
+AnalysisResult analyzePackTab(const PackReader &pack, size_t tab);
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string_view>
+
+// Compile-time friendly ASCII helpers for matching protocol tokens (header
+// and attribute names) against lowercase literals.
+namespace ascii {
+
+constexpr char lower(char c) { return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + 32) : c; }
+
+// `s` equals the lowercase literal `lit`, ignoring ASCII case.
+constexpr bool is(std::string_view s, std::string_view lit) {
+  if (s.size() != lit.size()) return false;
+  for (size_t i = 0; i < s.size(); i++) {
+    if (lower(s[i]) != lit[i]) return false;
+  }
+  return true;
+}
+
+constexpr bool startsWithI(std::string_view s, std::string_view lit) {
+  return s.size() >= lit.size() && is(s.substr(0, lit.size()), lit);
+}
+
+constexpr bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+constexpr std::string_view trim(std::string_view s) {
+  while (!s.empty() && isSpace(s.front())) s.remove_prefix(1);
+  while (!s.empty() && isSpace(s.back())) s.remove_suffix(1);
+  return s;
+}
+
+}  // namespace ascii
@@ -0,0 +1,218 @@
+#include "batch.hpp"
+
+#include <glob.h>
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+
+#include "analysis.hpp"
+#include "report.hpp"
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+namespace {
+
+struct BatchItem {
+  std::string tracePath;
+  std::shared_ptr<const OpenPack> pack;  // set for a tab of a pack
+  size_t tab = 0;                        // the tab's position in the pack
+  std::optional<int> tabId;
+  std::string reportPath;
+  bool ok = false;
+  std::string error;
+  SeverityCounts counts;
+};
+
+bool hasGlobChars(const std::string &s) {
+  return s.find_first_of("*?[") != std::string::npos;
+}
+
+void addGlob(const std::string &pattern, std::vector<std::string> &out) {
+  glob_t g{};
+  if (::glob(pattern.c_str(), 0, nullptr, &g) == 0) {
+    for (size_t i = 0; i < g.gl_pathc; i++) out.emplace_back(g.gl_pathv[i]);
+  }
+  globfree(&g);
+}
+
+void addDirectory(const fs::path &dir, std::vector<std::string> &out) {
+  for (const auto &entry : fs::directory_iterator(dir)) {
+    const auto ext = entry.path().extension();
+    if (entry.is_regular_file() && (ext == ".json" || ext == ".alpk")) {
+      out.push_back(entry.path().string());
+    }
+  }
+}
+
+void addList(const std::string &listPath, std::vector<std::string> &out) {
+  std::ifstream in(listPath);
+  if (!in) throw std::runtime_error("Failed to open trace list: " + listPath);
+  std::string line;
+  while (std::getline(in, line)) {
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (!line.empty() && line[0] != '#') out.push_back(line);
+  }
+}
+
+// Report file names are derived from the trace stem, plus "-tab<ID>" for a
+// tab of a pack. A name already taken, whether by an earlier trace with the
+// same stem or by one whose stem ends in a suffix, gets the next free numeric
+// suffix in input order, so no two items share a report.
+void assignReportPaths(std::vector<BatchItem> &items, const std::string &outDir) {
+  std::unordered_set<std::string> taken;
+  for (auto &item : items) {
+    std::string stem = fs::path(item.tracePath).stem().string();
+    if (item.tabId) stem += "-tab" + std::to_string(*item.tabId);
+    std::string name = stem;
+    for (int n = 2; !taken.insert(name).second; n++) name = stem + "-" + std::to_string(n);
+    item.reportPath = (fs::path(outDir) / (name + ".report.json")).string();
+  }
+}
+
+// One item per trace, or per tab for a pack. A pack that is malformed or
+// empty stays a single item, so analyzing it reports the error.
+std::vector<BatchItem> batchItems(const std::vector<std::string> &traces) {
+  std::vector<BatchItem> items;
+  items.reserve(traces.size());
+  for (const auto &path : traces) {
+    std::shared_ptr<const OpenPack> pack;
+    try {
+      pack = openPack(path);
+    } catch (const std::exception &) {
+    }
+    if (!pack || pack->reader->tabCount() == 0) {
+      items.emplace_back().tracePath = path;
+      continue;
+    }
+    for (size_t tab = 0; tab < pack->reader->tabCount(); tab++) {
+      BatchItem &item = items.emplace_back();
+      item.tracePath = path;
+      item.pack = pack;
+      item.tab = tab;
+      item.tabId = pack->reader->meta(tab).tabId;
+    }
+  }
+  return items;
+}
+
+}  // namespace
+
+std::vector<std::string> expandBatchInputs(const std::vector<std::string> &inputs) {
+  std::vector<std::string> out;
+  for (const auto &in : inputs) {
+    if (!in.empty() && in[0] == '@') {
+      addList(in.substr(1), out);
+    } else if (fs::is_directory(in)) {
+      addDirectory(in, out);
+    } else if (hasGlobChars(in)) {
+      addGlob(in, out);
+    } else {
+      out.push_back(in);
+    }
+  }
+  std::sort(out.begin(), out.end());
+  out.erase(std::unique(out.begin(), out.end()), out.end());
+  return out;
+}
+
+int runBatch(const BatchOptions &opts) {
+  std::vector<std::string> traces;
+  try {
+    traces = expandBatchInputs(opts.inputs);
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << "\n";
+    return 1;
+  }
+  if (traces.empty()) {
+    std::cerr << "No traces matched the batch inputs.\n";
+    return 1;
+  }
+
+  std::error_code ec;
+  fs::create_directories(opts.outDir, ec);
+  if (ec) {
+    std::cerr << "Failed to create output directory: " << opts.outDir << "\n";
+    return 1;
+  }
+
+  std::vector<BatchItem> items = batchItems(traces);
+  assignReportPaths(items, opts.outDir);
+
+  // Workers claim the next unprocessed index; each writes only its own slot,
+  // so no locking is needed and results stay in input order.
+  std::atomic<size_t> next{0};
+  auto worker = [&]() {
+    for (size_t i = next++; i < items.size(); i = next++) {
+      BatchItem &item = items[i];
+      try {
+        AnalysisResult result = item.pack ? analyzePackTab(*item.pack->reader, item.tab)
+                                          : analyzeTraceFile(item.tracePath);
+        item.counts = countSeverities(result.findings);
+        writeReportFile(item.reportPath, result.meta, result.findings, opts.compact);
+        item.ok = true;
+      } catch (const std::exception &e) {
+        item.error = e.what();
+      }
+    }
+  };
+
+  unsigned jobs = opts.jobs ? opts.jobs : std::max(1u, std::thread::hardware_concurrency());
+  jobs = static_cast<unsigned>(std::min<size_t>(jobs, items.size()));
+  std::vector<std::thread> pool;
+  pool.reserve(jobs);
+  for (unsigned t = 0; t < jobs; t++) pool.emplace_back(worker);
+  for (auto &t : pool) t.join();
+
+  SeverityCounts totals;
+  int failed = 0;
+  json summary;
+  summary["version"] = 1;
+  summary["traces"] = json::array();
+  for (const auto &item : items) {
+    json entry = {{"trace", item.tracePath}};
+    std::string label = item.tracePath;
+    if (item.tabId) {
+      entry["tabId"] = *item.tabId;
+      label += " tab " + std::to_string(*item.tabId);
+    }
+    if (item.ok) {
+      totals.add(item.counts);
+      entry["report"] = item.reportPath;
+      entry["summary"] = summaryJson(item.counts);
+      std::cout << label << ": HIGH=" << item.counts.high
+                << " MED=" << item.counts.med << " LOW=" << item.counts.low << "\n";
+    } else {
+      failed++;
+      entry["error"] = item.error;
+      std::cerr << label << ": " << item.error << "\n";
+    }
+    summary["traces"].push_back(std::move(entry));
+  }
+  summary["analyzed"] = static_cast<int>(items.size()) - failed;
+  summary["failed"] = failed;
+  summary["summary"] = summaryJson(totals);
+
+  const std::string summaryPath =
+      opts.summaryPath.empty() ? (fs::path(opts.outDir) / "summary.json").string()
+                               : opts.summaryPath;
+  try {
+    writeJsonFile(summaryPath, summary, opts.compact);
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << "\n";
+    return 1;
+  }
+
+  std::cout << "Findings: HIGH=" << totals.high << " MED=" << totals.med
+            << " LOW=" << totals.low << "\n";
+  std::cout << "Wrote: " << summaryPath << "\n";
+  return failed > 0 ? 1 : 0;
+}
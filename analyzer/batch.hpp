@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+struct BatchOptions {
+  // Each input is a trace file or pack, a directory (its *.json and *.alpk
+  // files), a glob pattern, or @list.txt naming one trace path per line.
+  // Every tab of a pack is analyzed into its own report.
+  std::vector<std::string> inputs;
+  std::string outDir = "reports";
+  std::string summaryPath;  // defaults to <outDir>/summary.json
+  unsigned jobs = 0;        // 0 picks std::thread::hardware_concurrency()
+  bool compact = false;     // unindented reports and summary
+};
+
+// Expands inputs into a sorted, de-duplicated list of trace paths.
+std::vector<std::string> expandBatchInputs(const std::vector<std::string> &inputs);
+
+// Analyzes every trace on a worker pool and writes one report per trace plus
+// an aggregated summary. Reports, summary entries and console lines follow
+// the expanded input order regardless of which worker finished first.
+// Returns the process exit code: non-zero if any trace failed.
+int runBatch(const BatchOptions &opts);
@@ -0,0 +1,250 @@
+// Throughput benchmark for the analyzer pipeline. Generates (or loads) a
+// trace and times each stage on its own:
+//   parse     scanner over the in-memory document, events discarded
+//   classify  EventContext construction (URL split, endpoint class)
+//   rules     RuleEngine dispatch over pre-classified events, plus finish()
+//   report    streamed report writer into memory; it has no events/s, and
+//             its MB/s counts the report bytes written
+//   total     parse + classify + rules + report as `authlens analyze` runs them
+// Each stage runs --iterations times and the fastest run is reported. Peak
+// RSS is the growth of the process high-water mark during the stage's first
+// run, so later stages only show memory beyond what earlier ones touched.
+// A rate that does not apply to a stage prints as "-" (null with --json).
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bench/trace_gen.hpp"
+#include "report.hpp"
+#include "rules.hpp"
+#include "trace.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct StageResult {
+  std::string name;
+  double seconds = 0;
+  size_t events = 0;  // 0: the stage has no event rate
+  size_t bytes = 0;   // 0: the stage has no byte rate
+  double rssGrowthMb = 0;
+};
+
+// `count` per second formatted with `fmt`, or `none` when there is no count.
+std::string rate(size_t count, double scale, double seconds, const char *fmt, const char *none) {
+  if (count == 0) return none;
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), fmt, static_cast<double>(count) / scale / seconds);
+  return buf;
+}
+
+double peakRssMb() {
+  rusage ru{};
+  getrusage(RUSAGE_SELF, &ru);
+#ifdef __APPLE__
+  return static_cast<double>(ru.ru_maxrss) / (1024.0 * 1024.0);
+#else
+  return static_cast<double>(ru.ru_maxrss) / 1024.0;
+#endif
+}
+
+template <typename Fn>
+StageResult runStage(const std::string &name, int iterations, size_t events, size_t bytes,
+                     Fn &&fn) {
+  StageResult r{name, 0, events, bytes, 0};
+  for (int i = 0; i < iterations; i++) {
+    const double rssBefore = peakRssMb();
+    const auto start = Clock::now();
+    fn();
+    const double secs = std::chrono::duration<double>(Clock::now() - start).count();
+    if (i == 0) {
+      r.seconds = secs;
+      r.rssGrowthMb = peakRssMb() - rssBefore;
+    } else {
+      r.seconds = std::min(r.seconds, secs);
+    }
+  }
+  return r;
+}
+
+// Copies an event so it owns its strings and can outlive the parser's buffer.
+TraceEvent cloneEvent(const TraceEvent &ev) {
+  TraceEvent out;
+  out.tMs = ev.tMs;
+  out.status = ev.status;
+  out.type = out.keep(std::string(ev.type));
+  out.requestId = out.keep(std::string(ev.requestId));
+  out.method = out.keep(std::string(ev.method));
+  out.url = out.keep(std::string(ev.url));
+  out.initiator = out.keep(std::string(ev.initiator));
+  out.hasRequestBodyKeys = ev.hasRequestBodyKeys;
+  for (auto k : ev.requestBodyKeys) out.requestBodyKeys.push_back(out.keep(std::string(k)));
+  for (const auto &h : ev.requestHeaders) {
+    out.requestHeaders.push_back({out.keep(std::string(h.name)), out.keep(std::string(h.value))});
+  }
+  for (const auto &h : ev.responseHeaders) {
+    out.responseHeaders.push_back({out.keep(std::string(h.name)), out.keep(std::string(h.value))});
+  }
+  return out;
+}
+
+void usage() {
+  std::cerr << "Usage: authlens_bench [--events N] [--flows N] [--cookies N] [--url-length N]\n"
+               "                      [--authorize R] [--token R] [--callback R]\n"
+               "                      [--cookie-responses R] [--seed N] [--iterations N]\n"
+               "                      [--trace trace.json] [--write-trace out.json] [--json]\n";
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  TraceGenOptions gen;
+  int iterations = 3;
+  std::string tracePath;
+  std::string writePath;
+  bool jsonOut = false;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    auto next = [&]() -> const char * {
+      if (i + 1 >= argc) {
+        usage();
+        std::exit(1);
+      }
+      return argv[++i];
+    };
+    if (arg == "--events") gen.events = std::strtoull(next(), nullptr, 10);
+    else if (arg == "--flows") gen.flows = std::atoi(next());
+    else if (arg == "--cookies") gen.cookiesPerResponse = std::atoi(next());
+    else if (arg == "--url-length") gen.urlLength = std::strtoull(next(), nullptr, 10);
+    else if (arg == "--authorize") gen.authorizeRatio = std::atof(next());
+    else if (arg == "--token") gen.tokenRatio = std::atof(next());
+    else if (arg == "--callback") gen.callbackRatio = std::atof(next());
+    else if (arg == "--cookie-responses") gen.cookieResponseRatio = std::atof(next());
+    else if (arg == "--seed") gen.seed = static_cast<uint32_t>(std::strtoul(next(), nullptr, 10));
+    else if (arg == "--iterations") iterations = std::max(1, std::atoi(next()));
+    else if (arg == "--trace") tracePath = next();
+    else if (arg == "--write-trace") writePath = next();
+    else if (arg == "--json") jsonOut = true;
+    else {
+      usage();
+      return 1;
+    }
+  }
+
+  std::string doc;
+  if (!tracePath.empty()) {
+    std::ifstream in(tracePath, std::ios::binary);
+    if (!in) {
+      std::cerr << "Failed to open trace: " << tracePath << "\n";
+      return 1;
+    }
+    doc.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  } else {
+    std::ostringstream out;
+    generateTrace(gen, out);
+    doc = out.str();
+  }
+  if (!writePath.empty()) {
+    std::ofstream out(writePath, std::ios::binary);
+    out << doc;
+    std::cout << "Wrote: " << writePath << " (" << doc.size() << " bytes)\n";
+    return out ? 0 : 1;
+  }
+
+  // Materialize the events once so classify/rules can be timed in isolation.
+  std::vector<TraceEvent> events;
+  TraceMeta meta;
+  try {
+    meta = readTraceBuffer(doc, [&](const TraceEvent &ev) {
+      if (!ev.url.empty()) events.push_back(cloneEvent(ev));
+    });
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << "\n";
+    return 1;
+  }
+  const size_t n = events.size();
+  const size_t bytes = doc.size();
+
+  std::vector<StageResult> results;
+  volatile size_t sinkCount = 0;
+
+  results.push_back(runStage("parse", iterations, n, bytes, [&] {
+    size_t count = 0;
+    readTraceBuffer(doc, [&](const TraceEvent &) { count++; });
+    sinkCount = count;
+  }));
+
+  results.push_back(runStage("classify", iterations, n, bytes, [&] {
+    unsigned acc = 0;
+    for (const auto &ev : events) {
+      EventContext ctx(ev);
+      acc += ctx.endpoint + static_cast<unsigned>(ctx.query.raw().size());
+    }
+    sinkCount = acc;
+  }));
+
+  std::vector<EventContext> contexts;
+  contexts.reserve(n);
+  for (const auto &ev : events) contexts.emplace_back(ev);
+
+  FindingSet findings;
+  results.push_back(runStage("rules", iterations, n, bytes, [&] {
+    RuleEngine engine;
+    for (auto &ctx : contexts) engine.dispatch(ctx);
+    engine.finish();
+    findings = engine.takeFindings();
+  }));
+
+  size_t reportBytes = 0;
+  results.push_back(runStage("report", iterations, 0, 0, [&] {
+    std::ostringstream out;
+    writeReport(out, meta, findings);
+    reportBytes = out.str().size();
+  }));
+  results.back().bytes = reportBytes;
+
+  results.push_back(runStage("total", iterations, n, bytes, [&] {
+    RuleEngine engine;
+    TraceMeta m = readTraceBuffer(doc, [&](const TraceEvent &ev) { engine.onEvent(ev); });
+    engine.finish();
+    std::ostringstream out;
+    writeReport(out, m, engine.findings());
+    sinkCount = out.str().size();
+  }));
+
+  if (jsonOut) {
+    std::cout << "{\"events\":" << n << ",\"bytes\":" << bytes
+              << ",\"findings\":" << findings.size() << ",\"stages\":[";
+    for (size_t i = 0; i < results.size(); i++) {
+      const auto &r = results[i];
+      std::cout << (i ? "," : "") << "{\"stage\":\"" << r.name << "\",\"seconds\":" << r.seconds
+                << ",\"eventsPerSec\":" << rate(r.events, 1, r.seconds, "%.17g", "null")
+                << ",\"mbPerSec\":" << rate(r.bytes, 1e6, r.seconds, "%.17g", "null")
+                << ",\"peakRssGrowthMb\":" << r.rssGrowthMb << "}";
+    }
+    std::cout << "],\"peakRssMb\":" << peakRssMb() << "}\n";
+    return 0;
+  }
+
+  std::printf("trace: %zu events, %.1f MB, %zu findings, best of %d\n", n, bytes / 1e6,
+              findings.size(), iterations);
+  std::printf("%-10s %10s %14s %10s %14s\n", "stage", "ms", "events/s", "MB/s", "peak RSS +MB");
+  for (const auto &r : results) {
+    std::printf("%-10s %10.2f %14s %10s %14.1f\n", r.name.c_str(), r.seconds * 1e3,
+                rate(r.events, 1, r.seconds, "%.0f", "-").c_str(),
+                rate(r.bytes, 1e6, r.seconds, "%.1f", "-").c_str(), r.rssGrowthMb);
+  }
+  std::printf("peak RSS: %.1f MB\n", peakRssMb());
+  return 0;
+}
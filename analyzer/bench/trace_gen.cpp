@@ -0,0 +1,95 @@
+#include "bench/trace_gen.hpp"
+
+#include <random>
+#include <string>
+
+namespace {
+
+class Generator {
+ public:
+  Generator(const TraceGenOptions &opts, std::ostream &out)
+      : opts_(opts), out_(out), rng_(opts.seed) {}
+
+  void run() {
+    out_ << "{\"version\":1,\"tabId\":42,\"startedAtMs\":1730000000000,\"events\":[";
+    for (size_t i = 0; i < opts_.events; i++) {
+      if (i) out_ << ',';
+      event(i);
+    }
+    out_ << "]}\n";
+  }
+
+ private:
+  void event(size_t i) {
+    const int flow = static_cast<int>(i % static_cast<size_t>(opts_.flows > 0 ? opts_.flows : 1));
+    const std::string idp = "https://idp" + std::to_string(flow % 3) + ".example.com";
+    const std::string state = "st" + std::to_string(flow) + "_" + std::to_string(i / 64);
+    const double r = unit_(rng_);
+    const double authorizeEnd = opts_.authorizeRatio;
+    const double tokenEnd = authorizeEnd + opts_.tokenRatio;
+    const double callbackEnd = tokenEnd + opts_.callbackRatio;
+
+    out_ << "{\"tMs\":" << i * 5 << ",\"type\":\"HTTP\",\"requestId\":\"r" << i << '"';
+    if (r < authorizeEnd) {
+      url(idp + "/oauth/authorize?client_id=client" + std::to_string(flow) +
+          "&response_type=code&scope=openid%20profile&state=" + state + "&nonce=n" +
+          std::to_string(i) + "&code_challenge=E9Melhoa2OwvFrEMTJguCHaoeK1t8URWbuGJSstw-cM" +
+          "&code_challenge_method=S256&redirect_uri=https%3A%2F%2Fapp.example.com%2Fcallback");
+      method("GET");
+    } else if (r < tokenEnd) {
+      url(idp + "/oauth/token");
+      method("POST");
+      out_ << ",\"status\":200,\"requestBodyKeys\":[\"grant_type\",\"code\",\"code_verifier\","
+              "\"redirect_uri\"]";
+      cookies();
+    } else if (r < callbackEnd) {
+      url("https://app.example.com/callback?code=%3Credacted%20len%3D20%3E&state=" + state);
+      method("GET");
+    } else {
+      url("https://app.example.com/assets/app" + std::to_string(i % 97) + ".js?v=" +
+          std::to_string(rng_() % 100000) + "&lang=en-US");
+      method("GET");
+      out_ << ",\"status\":200";
+      if (unit_(rng_) < opts_.cookieResponseRatio) cookies();
+    }
+    out_ << '}';
+  }
+
+  void url(std::string u) {
+    if (u.size() < opts_.urlLength) {
+      u += u.find('?') == std::string::npos ? "?pad=" : "&pad=";
+      while (u.size() < opts_.urlLength) u.push_back(static_cast<char>('a' + rng_() % 26));
+    }
+    out_ << ",\"url\":\"" << u << '"';
+  }
+
+  void method(const char *m) { out_ << ",\"method\":\"" << m << '"'; }
+
+  void cookies() {
+    static const char *const kCookies[] = {
+        "sid=%s; Path=/; Secure; HttpOnly; SameSite=Lax",
+        "session_id=%s; Path=/; HttpOnly",
+        "pref=%s; Max-Age=31536000; Path=/",
+        "tracking=%s; Expires=Wed, 21 Oct 2026 07:28:00 GMT; SameSite=None",
+        "csrf=%s; Path=/; Secure; SameSite=Strict",
+    };
+    out_ << ",\"responseHeaders\":[{\"name\":\"Content-Type\",\"value\":\"text/html\"}";
+    for (int c = 0; c < opts_.cookiesPerResponse; c++) {
+      std::string value = kCookies[rng_() % (sizeof(kCookies) / sizeof(kCookies[0]))];
+      value.replace(value.find("%s"), 2, std::to_string(rng_()));
+      out_ << ",{\"name\":\"Set-Cookie\",\"value\":\"" << value << "\"}";
+    }
+    out_ << ']';
+  }
+
+  const TraceGenOptions &opts_;
+  std::ostream &out_;
+  std::mt19937 rng_;
+  std::uniform_real_distribution<double> unit_{0.0, 1.0};
+};
+
+}  // namespace
+
+void generateTrace(const TraceGenOptions &opts, std::ostream &out) {
+  Generator(opts, out).run();
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// Shape of a synthetic trace. Ratios pick each event's kind; whatever is left
+// over after authorize/token/callback becomes ordinary page traffic.
+struct TraceGenOptions {
+  size_t events = 100000;
+  int flows = 4;               // concurrent logins (distinct client/state) in the tab
+  int cookiesPerResponse = 3;  // Set-Cookie headers on responses that carry any
+  size_t urlLength = 160;      // URLs shorter than this are padded up to it
+  double authorizeRatio = 0.02;
+  double tokenRatio = 0.02;
+  double callbackRatio = 0.02;
+  double cookieResponseRatio = 0.2;  // share of page traffic that sets cookies
+  uint32_t seed = 1;
+};
+
+// Writes a trace in the extension's export schema (extension/src/trace.ts).
+// Output is deterministic for a given options struct.
+void generateTrace(const TraceGenOptions &opts, std::ostream &out);
@@ -0,0 +1,197 @@
+#include "checkpoint.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+
+#include "mapped_file.hpp"
+#include "pack.hpp"
+#include "stats.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+
+constexpr int kCheckpointVersion = 3;
+
+}  // namespace
+
+void PrefixHash::mixWord(uint64_t w) {
+  h_ = (h_ ^ w) * 0x9e3779b97f4a7c15ull;
+  h_ ^= h_ >> 29;
+}
+
+void PrefixHash::update(std::string_view bytes) {
+  length_ += bytes.size();
+  const char *p = bytes.data();
+  size_t n = bytes.size();
+  if (pendingSize_ > 0) {
+    const size_t take = std::min(n, sizeof(pending_) - pendingSize_);
+    std::memcpy(pending_ + pendingSize_, p, take);
+    pendingSize_ += take;
+    p += take;
+    n -= take;
+    if (pendingSize_ < sizeof(pending_)) return;
+    uint64_t w;
+    std::memcpy(&w, pending_, sizeof(w));
+    mixWord(w);
+    pendingSize_ = 0;
+  }
+  for (; n >= 8; p += 8, n -= 8) {
+    uint64_t w;
+    std::memcpy(&w, p, sizeof(w));
+    mixWord(w);
+  }
+  std::memcpy(pending_, p, n);
+  pendingSize_ = n;
+}
+
+uint64_t PrefixHash::digest() const {
+  uint64_t tail = 0;
+  std::memcpy(&tail, pending_, pendingSize_);
+  uint64_t h = (h_ ^ tail) * 0x9e3779b97f4a7c15ull;
+  h ^= length_;
+  h ^= h >> 32;
+  h *= 0xd6e8feb86659fd93ull;
+  return h ^ (h >> 32);
+}
+
+namespace {
+
+struct Checkpoint {
+  TraceResumePoint resume;
+  uint64_t prefixHash = 0;
+  json engine;
+};
+
+// Returns false with `reason` set if there is no usable checkpoint.
+bool loadCheckpoint(const std::string &path, Checkpoint &out, std::string &reason) {
+  std::ifstream in(path);
+  if (!in) {
+    reason = "no checkpoint";
+    return false;
+  }
+  try {
+    const json j = json::parse(in);
+    if (j.at("version").get<int>() != kCheckpointVersion) {
+      reason = "checkpoint version changed";
+      return false;
+    }
+    const json &meta = j.at("meta");
+    out.resume.offset = j.at("offset").get<size_t>();
+    out.resume.events = j.at("events").get<uint64_t>();
+    out.resume.meta.version = meta.at("version").get<int>();
+    out.resume.meta.tabId = meta.at("tabId").get<int>();
+    out.resume.meta.startedAtMs = meta.at("startedAtMs").get<int64_t>();
+    out.resume.meta.truncated = meta.at("truncated").get<bool>();
+    out.resume.meta.droppedEvents = meta.at("droppedEvents").get<int>();
+    out.prefixHash = std::stoull(j.at("prefixHash").get<std::string>(), nullptr, 16);
+    out.engine = j.at("engine");
+  } catch (const std::exception &) {
+    reason = "unreadable checkpoint";
+    return false;
+  }
+  return true;
+}
+
+void saveCheckpoint(const std::string &path, const Checkpoint &cp) {
+  const TraceMeta &m = cp.resume.meta;
+  char hash[17];
+  std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(cp.prefixHash));
+  const json j = {
+      {"version", kCheckpointVersion},
+      {"offset", cp.resume.offset},
+      {"events", cp.resume.events},
+      {"prefixHash", hash},
+      {"meta",
+       {{"version", m.version},
+        {"tabId", m.tabId},
+        {"startedAtMs", m.startedAtMs},
+        {"truncated", m.truncated},
+        {"droppedEvents", m.droppedEvents}}},
+      {"engine", cp.engine},
+  };
+
+  // Write-then-rename so an interrupted run never leaves a torn checkpoint;
+  // a failed write removes its temp file, like the report writer.
+  const std::string tmp = path + ".tmp";
+  try {
+    std::ofstream out(tmp);
+    if (!out) throw std::runtime_error("Failed to open checkpoint file: " + tmp);
+    out << j.dump() << "\n";
+    if (!out.flush()) throw std::runtime_error("Failed to write checkpoint file: " + tmp);
+  } catch (...) {
+    std::remove(tmp.c_str());
+    throw;
+  }
+  if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+    std::remove(tmp.c_str());
+    throw std::runtime_error("Failed to replace checkpoint file: " + path);
+  }
+}
+
+}  // namespace
+
+AnalysisResult analyzeIncremental(const std::string &tracePath, const std::string &checkpointPath,
+                                  IncrementalStats *stats) {
+  MappedFile mapped;
+  if (!mapped.open(tracePath) || isPack(mapped.data())) {
+    throw std::runtime_error("Checkpoints need a JSON trace file: " + tracePath);
+  }
+  const std::string_view doc = mapped.data();
+
+  IncrementalStats local;
+  IncrementalStats &st = stats ? *stats : local;
+  st = {};
+
+  std::optional<RuleEngine> engine;
+  engine.emplace();
+  PrefixHash hash;
+  Checkpoint cp;
+  if (loadCheckpoint(checkpointPath, cp, st.restartReason)) {
+    if (cp.resume.offset > doc.size()) {
+      st.restartReason = "trace is shorter than the checkpoint";
+    } else {
+      hash.update(doc.substr(0, cp.resume.offset));
+      if (hash.digest() != cp.prefixHash) {
+        st.restartReason = "trace does not extend the checkpointed one";
+      } else {
+        try {
+          engine->loadState(cp.engine);
+          st.resumed = true;
+        } catch (const std::exception &e) {
+          st.restartReason = e.what();
+        }
+      }
+    }
+  }
+  if (!st.resumed) {
+    engine.emplace();
+    hash = PrefixHash();
+    cp.resume = {};
+  }
+  st.skippedEvents = cp.resume.events;
+  const size_t start = cp.resume.offset;
+
+  AnalysisResult result;
+  {
+    Stats *collector = activeStats();
+    if (collector) collector->add(Counter::BytesRead, doc.size() - start);
+    ReadTimer timer(collector);
+    auto onEvent = [&](const TraceEvent &ev) { engine->onEvent(ev); };
+    result.meta = readTraceBuffer(doc, timer.wrap(onEvent), &cp.resume);
+  }
+  st.newEvents = cp.resume.events - st.skippedEvents;
+
+  hash.update(doc.substr(start, cp.resume.offset - start));
+  cp.prefixHash = hash.digest();
+  cp.engine = engine->saveState();
+  saveCheckpoint(checkpointPath, cp);
+
+  engine->finish();
+  result.findings = engine->takeFindings();
+  return result;
+}
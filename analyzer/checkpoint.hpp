@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "analysis.hpp"
+#include "trace.hpp"
+
+// Streaming 64-bit hash used to recognize a trace prefix seen before. Fast
+// and order-sensitive, not cryptographic: it detects an edited or different
+// file, not a deliberately forged one.
+class PrefixHash {
+ public:
+  void update(std::string_view bytes);
+  // Hash of everything passed to update() so far; update() may continue.
+  uint64_t digest() const;
+
+ private:
+  void mixWord(uint64_t w);
+
+  uint64_t h_ = 0x243f6a8885a308d3ull;
+  uint64_t length_ = 0;
+  unsigned char pending_[8] = {};
+  size_t pendingSize_ = 0;
+};
+
+struct IncrementalStats {
+  bool resumed = false;
+  std::string restartReason;  // why an existing checkpoint was not used
+  uint64_t skippedEvents = 0;  // events covered by the checkpoint
+  uint64_t newEvents = 0;      // events analyzed in this run
+};
+
+// Analyzes a JSON trace file, resuming from `checkpointPath` when it holds
+// the state of an earlier run over a prefix of the same trace (an older
+// export of a growing session), then rewrites the checkpoint for the next
+// run. The report equals that of a full analysis. A missing, stale or
+// unreadable checkpoint falls back to analyzing from the first event. Throws
+// std::runtime_error if the trace is not a regular JSON file, cannot be
+// parsed, or the checkpoint cannot be written.
+AnalysisResult analyzeIncremental(const std::string &tracePath, const std::string &checkpointPath,
+                                  IncrementalStats *stats = nullptr);
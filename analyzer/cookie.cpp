@@ -0,0 +1,24 @@
+#include "cookie.hpp"
+
+// The recognizer is constexpr; these pin its behavior at compile time.
+
+static_assert(cookieAttrOf("Max-Age") == CookieAttr::MaxAge);
+static_assert(cookieAttrOf("SECURE") == CookieAttr::Secure);
+static_assert(!cookieAttrOf("secured"));
+
+static_assert([] {
+  constexpr auto c = parseSetCookie(" sid = abc ; Path=/; SameSite=None ;Secure;samesite=Lax");
+  return c.name == "sid" && c.value == "abc" && c.path == "/" && c.sameSite == "Lax" &&
+         c.has(CookieAttr::Secure) && !c.has(CookieAttr::HttpOnly) && !isSameSiteNone(c);
+}());
+
+static_assert([] {
+  constexpr auto c = parseSetCookie("__Host-id=1; Max-Age=60; Partitioned; Domain=example.com");
+  return c.hostPrefix() && !c.securePrefix() && c.has(CookieAttr::Partitioned) &&
+         c.domain == "example.com" && !isSessionish(c);
+}());
+
+static_assert(isSessionish(parseSetCookie("theme=dark")));
+static_assert(isSessionish(parseSetCookie("APP_SESS=1; Expires=Wed, 21 Oct 2026 07:28:00 GMT")));
+static_assert(!isSessionish(parseSetCookie("theme=dark; Expires=Wed, 21 Oct 2026 07:28:00 GMT")));
+static_assert(parseSetCookie(";; =v; x").name.empty() && parseSetCookie(";; =v; x").value == "v");
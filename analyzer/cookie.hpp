@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include "ascii.hpp"
+
+// Set-Cookie attributes the rules know about. Anything else is skipped.
+enum class CookieAttr : uint8_t {
+  Secure,
+  HttpOnly,
+  SameSite,
+  Expires,
+  MaxAge,
+  Domain,
+  Path,
+  Partitioned,
+  Priority,
+};
+
+// Recognizes an attribute name case-insensitively. The length picks the
+// candidates, so each name is compared with at most three literals.
+constexpr std::optional<CookieAttr> cookieAttrOf(std::string_view name) {
+  using ascii::is;
+  switch (name.size()) {
+    case 4:
+      if (is(name, "path")) return CookieAttr::Path;
+      break;
+    case 6:
+      if (is(name, "secure")) return CookieAttr::Secure;
+      if (is(name, "domain")) return CookieAttr::Domain;
+      break;
+    case 7:
+      if (is(name, "expires")) return CookieAttr::Expires;
+      if (is(name, "max-age")) return CookieAttr::MaxAge;
+      break;
+    case 8:
+      if (is(name, "httponly")) return CookieAttr::HttpOnly;
+      if (is(name, "samesite")) return CookieAttr::SameSite;
+      if (is(name, "priority")) return CookieAttr::Priority;
+      break;
+    case 11:
+      if (is(name, "partitioned")) return CookieAttr::Partitioned;
+      break;
+  }
+  return std::nullopt;
+}
+
+// One Set-Cookie header value, parsed without allocating. All views point
+// into the header, trimmed of surrounding whitespace. When an attribute is
+// repeated, the last occurrence wins.
+struct ParsedCookie {
+  std::string_view name;
+  std::string_view value;
+  uint16_t attrs = 0;  // bit per CookieAttr present
+  std::string_view sameSite;
+  std::string_view domain;
+  std::string_view path;
+
+  constexpr bool has(CookieAttr a) const { return (attrs >> static_cast<unsigned>(a)) & 1u; }
+
+  // Cookie name prefixes that make browsers enforce Secure (both) and a
+  // host-only cookie with Path=/ (__Host-).
+  constexpr bool hostPrefix() const { return ascii::startsWithI(name, "__host-"); }
+  constexpr bool securePrefix() const { return ascii::startsWithI(name, "__secure-"); }
+};
+
+constexpr ParsedCookie parseSetCookie(std::string_view sc) {
+  using ascii::trim;
+  ParsedCookie out;
+  bool first = true;
+  while (!sc.empty()) {
+    const size_t sep = sc.find(';');
+    const std::string_view part = trim(sc.substr(0, sep));
+    sc = sep == std::string_view::npos ? std::string_view() : sc.substr(sep + 1);
+    if (part.empty()) continue;
+
+    const size_t eq = part.find('=');
+    const std::string_view key = trim(part.substr(0, eq));
+    const std::string_view value = eq == std::string_view::npos ? std::string_view()
+                                                                : trim(part.substr(eq + 1));
+    if (first) {
+      first = false;
+      out.name = eq == std::string_view::npos ? part : key;
+      out.value = value;
+      continue;
+    }
+    const auto attr = cookieAttrOf(key);
+    if (!attr) continue;
+    out.attrs |= static_cast<uint16_t>(1u << static_cast<unsigned>(*attr));
+    if (*attr == CookieAttr::SameSite) out.sameSite = value;
+    else if (*attr == CookieAttr::Domain) out.domain = value;
+    else if (*attr == CookieAttr::Path) out.path = value;
+  }
+  return out;
+}
+
+// No explicit lifetime, or a name that looks like a session identifier
+// (contains "sid" or "sess", ignoring case).
+constexpr bool isSessionish(const ParsedCookie &cookie) {
+  if (!cookie.has(CookieAttr::Expires) && !cookie.has(CookieAttr::MaxAge)) return true;
+  const std::string_view n = cookie.name;
+  for (size_t i = 0; i + 3 <= n.size(); i++) {
+    if (ascii::lower(n[i]) != 's') continue;
+    if (ascii::is(n.substr(i + 1, 2), "id") || ascii::is(n.substr(i + 1, 3), "ess")) {
+      return true;
+    }
+  }
+  return false;
+}
+
+constexpr bool isSameSiteNone(const ParsedCookie &cookie) {
+  return cookie.has(CookieAttr::SameSite) && ascii::is(cookie.sameSite, "none");
+}
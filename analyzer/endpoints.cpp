@@ -0,0 +1,194 @@
+#include "endpoints.hpp"
+
+#include <fstream>
+#include <stdexcept>
+
+#include "ascii.hpp"
+#include "third_party/json.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+
+json readJson(const std::string &path, const char *what) {
+  std::ifstream in(path);
+  if (!in) throw std::runtime_error(std::string("Failed to open ") + what + ": " + path);
+  try {
+    return json::parse(in);
+  } catch (const json::exception &e) {
+    throw std::runtime_error(std::string("Invalid ") + what + " " + path + ": " + e.what());
+  }
+}
+
+std::vector<std::string> patternList(const json &doc, const char *key, const std::string &path) {
+  std::vector<std::string> out;
+  auto it = doc.find(key);
+  if (it == doc.end()) return out;
+  if (!it->is_array()) {
+    throw std::runtime_error("Invalid endpoint profile " + path + ": \"" + key +
+                             "\" must be an array of strings");
+  }
+  for (const auto &p : *it) {
+    if (!p.is_string() || p.get_ref<const std::string &>().empty()) {
+      throw std::runtime_error("Invalid endpoint profile " + path + ": \"" + key +
+                               "\" must hold non-empty strings");
+    }
+    out.push_back(p.get<std::string>());
+  }
+  return out;
+}
+
+// host+path of an endpoint URL, the text patterns are matched against.
+std::string hostPath(std::string_view url) {
+  const UrlView v(url);
+  return std::string(v.host) + std::string(v.path);
+}
+
+void fnv(uint64_t &h, std::string_view bytes) {
+  for (unsigned char c : bytes) {
+    h ^= c;
+    h *= 0x100000001b3ull;
+  }
+}
+
+}  // namespace
+
+const EndpointProfile &builtinEndpointProfile() {
+  static const EndpointProfile profile{"builtin", {"/authorize"}, {"/token"}};
+  return profile;
+}
+
+EndpointProfile loadEndpointProfile(const std::string &path) {
+  const json doc = readJson(path, "endpoint profile");
+  if (!doc.is_object()) throw std::runtime_error("Invalid endpoint profile " + path);
+  EndpointProfile profile;
+  profile.name = doc.value("name", path);
+  profile.authorize = patternList(doc, "authorize", path);
+  profile.token = patternList(doc, "token", path);
+  if (profile.authorize.empty() && profile.token.empty()) {
+    throw std::runtime_error("Endpoint profile has no patterns: " + path);
+  }
+  return profile;
+}
+
+EndpointProfile loadDiscoveryDocument(const std::string &path) {
+  const json doc = readJson(path, "discovery document");
+  if (!doc.is_object()) throw std::runtime_error("Invalid discovery document " + path);
+  EndpointProfile profile;
+  profile.name = doc.value("issuer", path);
+  auto endpoint = [&](const char *key, std::vector<std::string> &out) {
+    auto it = doc.find(key);
+    if (it == doc.end() || !it->is_string()) return;
+    std::string pattern = hostPath(it->get<std::string>());
+    if (!pattern.empty()) out.push_back(std::move(pattern));
+  };
+  endpoint("authorization_endpoint", profile.authorize);
+  endpoint("token_endpoint", profile.token);
+  if (profile.authorize.empty() && profile.token.empty()) {
+    throw std::runtime_error("Discovery document names no authorization or token endpoint: " +
+                             path);
+  }
+  return profile;
+}
+
+EndpointClassifier::EndpointClassifier(const std::vector<EndpointProfile> &profiles) {
+  std::vector<Pattern> patterns;
+  auto add = [&](const EndpointProfile &p) {
+    for (const auto *list : {&p.authorize, &p.token}) {
+      const unsigned cls = list == &p.authorize ? kEndpointAuthorize : kEndpointToken;
+      for (const auto &text : *list) {
+        Pattern pat{text, cls};
+        for (char &c : pat.text) c = ascii::lower(c);
+        patterns.push_back(std::move(pat));
+      }
+    }
+  };
+  add(builtinEndpointProfile());
+  for (const auto &p : profiles) add(p);
+  compile(patterns);
+}
+
+void EndpointClassifier::compile(const std::vector<Pattern> &patterns) {
+  // Byte classes: one per distinct pattern byte, shared by both cases of a
+  // letter, so the table stays narrow and matching needs no folding.
+  for (const auto &p : patterns) {
+    for (unsigned char c : p.text) {
+      if (byteClass_[c]) continue;
+      if (alphabet_ > 255) {
+        throw std::runtime_error("Endpoint patterns use too many distinct bytes.");
+      }
+      byteClass_[c] = static_cast<uint8_t>(alphabet_);
+      if (c >= 'a' && c <= 'z') byteClass_[c - 32] = static_cast<uint8_t>(alphabet_);
+      alphabet_++;
+    }
+  }
+
+  // Trie; 0 in next_ means "no edge" until the DFA is filled in (the root is
+  // never a goto target).
+  next_.assign(alphabet_, 0);
+  out_.assign(1, 0);
+  for (const auto &p : patterns) {
+    uint32_t s = 0;
+    for (unsigned char c : p.text) {
+      uint32_t &edge = next_[static_cast<size_t>(s) * alphabet_ + byteClass_[c]];
+      if (!edge) {
+        edge = static_cast<uint32_t>(out_.size());
+        out_.push_back(0);
+        next_.resize(next_.size() + alphabet_, 0);
+      }
+      s = next_[static_cast<size_t>(s) * alphabet_ + byteClass_[c]];
+    }
+    out_[s] |= static_cast<uint8_t>(p.cls);
+    fnv(fingerprint_, p.text);
+    fnv(fingerprint_, p.cls == kEndpointAuthorize ? std::string_view("\1") : "\2");
+    patterns_++;
+  }
+
+  // Breadth-first: resolve missing edges through failure links, so every
+  // state has a transition for every class, and inherit the outputs of the
+  // longest proper suffix state.
+  std::vector<uint32_t> fail(out_.size(), 0);
+  std::vector<uint32_t> queue;
+  for (uint32_t c = 0; c < alphabet_; c++) {
+    if (uint32_t t = next_[c]) queue.push_back(t);
+  }
+  for (size_t qi = 0; qi < queue.size(); qi++) {
+    const uint32_t s = queue[qi];
+    out_[s] |= out_[fail[s]];
+    for (uint32_t c = 0; c < alphabet_; c++) {
+      uint32_t &edge = next_[static_cast<size_t>(s) * alphabet_ + c];
+      const uint32_t viaFail = next_[static_cast<size_t>(fail[s]) * alphabet_ + c];
+      if (edge) {
+        fail[edge] = viaFail;
+        queue.push_back(edge);
+      } else {
+        edge = viaFail;
+      }
+    }
+  }
+}
+
+unsigned EndpointClassifier::classify(const UrlView &url) const {
+  uint32_t s = 0;
+  unsigned bits = 0;
+  for (std::string_view part : {url.host, url.path}) {
+    for (unsigned char c : part) {
+      s = next_[static_cast<size_t>(s) * alphabet_ + byteClass_[c]];
+      bits |= out_[s];
+    }
+  }
+  return (bits & kEndpointAuthorize) ? kEndpointAuthorize : bits;
+}
+
+namespace {
+
+EndpointClassifier &current() {
+  static EndpointClassifier classifier;
+  return classifier;
+}
+
+}  // namespace
+
+const EndpointClassifier &endpointClassifier() { return current(); }
+
+void setEndpointClassifier(EndpointClassifier classifier) { current() = std::move(classifier); }
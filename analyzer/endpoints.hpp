@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "url.hpp"
+
+enum EndpointClass : unsigned {
+  kEndpointNone = 0,
+  kEndpointAuthorize = 1u << 0,
+  kEndpointToken = 1u << 1,
+  kEndpointMaskCount = 1u << 2,  // number of distinct endpoint bitmasks
+};
+
+// Endpoint patterns of one IdP. A pattern is an ASCII case-insensitive
+// substring of the URL's host followed by its path (no query or fragment):
+// "/oauth2/v2.0/token" matches that path on any host, while
+// "login.example.com/connect/token" also pins the host.
+struct EndpointProfile {
+  std::string name;
+  std::vector<std::string> authorize;
+  std::vector<std::string> token;
+};
+
+// The generic patterns ("/authorize", "/token") every classifier includes.
+const EndpointProfile &builtinEndpointProfile();
+
+// Reads a profile file: {"name": "...", "authorize": [...], "token": [...]}.
+// Throws std::runtime_error if it cannot be read or is malformed.
+EndpointProfile loadEndpointProfile(const std::string &path);
+
+// Reads an OIDC discovery document saved locally and turns its
+// authorization_endpoint and token_endpoint URLs into host+path patterns.
+// Throws like loadEndpointProfile().
+EndpointProfile loadDiscoveryDocument(const std::string &path);
+
+// All patterns of a set of profiles compiled into one Aho-Corasick automaton,
+// stored as a full DFA over byte classes (letters fold to one class per
+// case). Classifying a URL is one table step per byte of host+path,
+// whatever the number of profiles. Authorize wins over token when a URL
+// matches both.
+class EndpointClassifier {
+ public:
+  // The built-in profile plus `profiles`.
+  explicit EndpointClassifier(const std::vector<EndpointProfile> &profiles = {});
+
+  unsigned classify(const UrlView &url) const;
+
+  // Identifies the compiled pattern set, so saved engine state can tell
+  // whether it was produced with the same classification.
+  uint64_t fingerprint() const { return fingerprint_; }
+  size_t patternCount() const { return patterns_; }
+
+ private:
+  struct Pattern {
+    std::string text;  // lowercase
+    unsigned cls;
+  };
+  void compile(const std::vector<Pattern> &patterns);
+
+  std::array<uint8_t, 256> byteClass_{};  // 0: byte in no pattern
+  uint32_t alphabet_ = 1;
+  std::vector<uint32_t> next_;  // state * alphabet_ + class -> state
+  std::vector<uint8_t> out_;  // EndpointClass bits matched on reaching a state
+  uint64_t fingerprint_ = 0xcbf29ce484222325ull;
+  size_t patterns_ = 0;
+};
+
+// The classifier events are classified with. Starts as the built-in profile;
+// replace it with setEndpointClassifier() before analysis starts (it is not
+// synchronized with running engines).
+const EndpointClassifier &endpointClassifier();
+void setEndpointClassifier(EndpointClassifier classifier);
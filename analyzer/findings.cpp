@@ -0,0 +1,42 @@
+#include "findings.hpp"
+
+#include <cstring>
+
+std::string_view StringArena::copy(std::string_view s) {
+  if (s.empty()) return {};
+  if (s.size() > left_) {
+    // Oversized strings get a chunk of their own so the current one keeps
+    // its free tail.
+    const size_t size = s.size() > kChunkSize / 4 ? s.size() : kChunkSize;
+    chunks_.push_back(std::make_unique<char[]>(size));
+    if (size != kChunkSize) {
+      std::memcpy(chunks_.back().get(), s.data(), s.size());
+      return {chunks_.back().get(), s.size()};
+    }
+    cur_ = chunks_.back().get();
+    left_ = size;
+  }
+  char *dst = cur_;
+  std::memcpy(dst, s.data(), s.size());
+  cur_ += s.size();
+  left_ -= s.size();
+  return {dst, s.size()};
+}
+
+bool FindingSet::add(const RuleInfo &rule, std::string_view evidence, uint32_t occurrences) {
+  occurrences_ += occurrences;
+  auto it = index_.find(Key{&rule, evidence});
+  if (it != index_.end()) {
+    findings_[it->second].count += occurrences;
+    return false;
+  }
+
+  // Rules frequently share evidence (every cookie rule quotes the same
+  // Set-Cookie header), so the text is interned across rules too.
+  auto stored = evidence_.find(evidence);
+  if (stored == evidence_.end()) stored = evidence_.insert(arena_.copy(evidence)).first;
+
+  index_.emplace(Key{&rule, *stored}, static_cast<uint32_t>(findings_.size()));
+  findings_.push_back({&rule, *stored, occurrences});
+  return true;
+}
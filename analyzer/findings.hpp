@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// The constant half of a finding. Each rule owns one static RuleInfo and
+// every finding it reports points at it, so titles and advice are never
+// copied per occurrence.
+struct RuleInfo {
+  std::string_view id;
+  std::string_view severity;
+  std::string_view confidence;
+  std::string_view title;
+  std::string_view why;
+  std::string_view fix;
+};
+
+// One distinct finding: a rule plus its evidence. `count` is how many times
+// the same rule reported the same evidence during the analysis.
+struct Finding {
+  const RuleInfo *rule = nullptr;
+  std::string_view evidence;  // empty when the rule has none
+  uint32_t count = 1;
+};
+
+// Bump allocator for strings that live as long as one analysis. Copies are
+// never freed individually and stay put when the arena is moved.
+class StringArena {
+ public:
+  std::string_view copy(std::string_view s);
+
+ private:
+  static constexpr size_t kChunkSize = 64 * 1024;
+
+  std::vector<std::unique_ptr<char[]>> chunks_;
+  char *cur_ = nullptr;
+  size_t left_ = 0;
+};
+
+// Findings of one analysis in first-seen order, deduplicated on (rule,
+// evidence). Evidence text is stored once in an arena owned by the set, so
+// memory grows with distinct findings rather than with events. Move-only.
+class FindingSet {
+ public:
+  // Records `occurrences` more sightings. Returns true if the finding is new.
+  bool add(const RuleInfo &rule, std::string_view evidence = {}, uint32_t occurrences = 1);
+
+  size_t size() const { return findings_.size(); }
+  bool empty() const { return findings_.empty(); }
+  // Sightings recorded so far, repeats included.
+  uint64_t occurrences() const { return occurrences_; }
+  const Finding &operator[](size_t i) const { return findings_[i]; }
+  auto begin() const { return findings_.begin(); }
+  auto end() const { return findings_.end(); }
+
+ private:
+  struct Key {
+    const RuleInfo *rule;
+    std::string_view evidence;
+    bool operator==(const Key &) const = default;
+  };
+  struct KeyHash {
+    size_t operator()(const Key &k) const {
+      return std::hash<std::string_view>{}(k.evidence) ^
+             (std::hash<const void *>{}(k.rule) * 0x9e3779b97f4a7c15ull);
+    }
+  };
+
+  StringArena arena_;
+  std::unordered_set<std::string_view> evidence_;  // interned, views into arena_
+  std::unordered_map<Key, uint32_t, KeyHash> index_;  // -> position in findings_
+  std::vector<Finding> findings_;
+  uint64_t occurrences_ = 0;
+};
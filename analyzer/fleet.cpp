@@ -0,0 +1,335 @@
+#include "fleet.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+
+#include "analysis.hpp"
+#include "ascii.hpp"
+#include "batch.hpp"
+#include "mapped_file.hpp"
+#include "report.hpp"
+#include "rules.hpp"
+#include "url.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+
+// Reports and batch summaries are written with sorted keys, so they are
+// told apart from traces by their first key: "findings" for a report,
+// "analyzed" for a summary.
+bool firstKeyIs(std::string_view data, std::string_view key) {
+  size_t i = 0;
+  auto skipSpace = [&] {
+    while (i < data.size() && ascii::isSpace(data[i])) i++;
+  };
+  skipSpace();
+  if (i == data.size() || data[i] != '{') return false;
+  i++;
+  skipSpace();
+  data.remove_prefix(i);
+  return data.size() > key.size() + 1 && data[0] == '"' && data.substr(1).starts_with(key) &&
+         data[key.size() + 1] == '"';
+}
+
+std::vector<FleetFinding> fromFindingSet(const FindingSet &findings) {
+  std::vector<FleetFinding> out;
+  out.reserve(findings.size());
+  for (const auto &f : findings) {
+    out.push_back({f.rule->id, f.rule->severity, f.rule->confidence, f.rule->title, f.evidence,
+                   f.count});
+  }
+  return out;
+}
+
+// One unit of work: a JSON trace or report, or one tab of a pack.
+struct WorkItem {
+  TraceOrder order;
+  std::shared_ptr<const OpenPack> pack;  // set for pack tabs
+};
+
+// Splits an input into work items: one per tab for a pack, else the input
+// itself. Packs open in constant time, so this stays cheap for archives.
+std::vector<WorkItem> workItems(const std::string &path, size_t input) {
+  auto pack = openPack(path);
+  if (!pack) return {{{input, 0}, nullptr}};
+  std::vector<WorkItem> items;
+  items.reserve(pack->reader->tabCount());
+  for (size_t tab = 0; tab < pack->reader->tabCount(); tab++) items.push_back({{input, tab}, pack});
+  return items;
+}
+
+// Adds the trace of one work item. Returns the number of traces added (0 for
+// a skipped batch summary).
+size_t aggregateItem(const std::string &path, const WorkItem &item, FleetAggregator &agg) {
+  if (item.pack) {
+    AnalysisResult result = analyzePackTab(*item.pack->reader, item.order.tab);
+    agg.add(item.order, result.meta.startedAtMs, fromFindingSet(result.findings));
+    return 1;
+  }
+
+  MappedFile mapped;
+  const bool isMapped = mapped.open(path);
+  const std::string_view data = mapped.data();
+
+  // analyze-batch writes its summary next to the reports; skip it so a
+  // batch output directory can be aggregated as is.
+  if (isMapped && firstKeyIs(data, "analyzed")) return 0;
+
+  if (isMapped && firstKeyIs(data, "findings")) {
+    const json report = json::parse(data);
+    const auto &list = report.at("findings");
+    if (!list.is_array()) throw std::runtime_error("Invalid report: " + path);
+    std::vector<FleetFinding> findings;
+    for (const auto &f : list) {
+      auto str = [&](const char *key) -> std::string_view {
+        auto it = f.find(key);
+        if (it == f.end() || !it->is_string()) return {};
+        return it->get_ref<const std::string &>();
+      };
+      FleetFinding ff{str("id"), str("severity"), str("confidence"), str("title"), {}, 1};
+      if (ff.id.empty()) throw std::runtime_error("Invalid report: " + path);
+      auto ev = f.find("evidence");
+      if (ev != f.end() && ev->is_array() && !ev->empty() && ev->front().is_string()) {
+        ff.evidence = ev->front().get_ref<const std::string &>();
+      }
+      ff.count = f.value("count", uint64_t{1});
+      findings.push_back(ff);
+    }
+    agg.add(item.order, report.value("startedAtMs", int64_t{0}), findings);
+    return 1;
+  }
+
+  AnalysisResult result = analyzeTraceFile(path);
+  agg.add(item.order, result.meta.startedAtMs, fromFindingSet(result.findings));
+  return 1;
+}
+
+// Runs fn(0..n-1) on up to `jobs` threads.
+void parallelFor(size_t n, unsigned jobs, const std::function<void(size_t)> &fn) {
+  std::atomic<size_t> next{0};
+  auto worker = [&]() {
+    for (size_t i = next++; i < n; i = next++) fn(i);
+  };
+  jobs = static_cast<unsigned>(std::min<size_t>(jobs, n));
+  std::vector<std::thread> pool;
+  pool.reserve(jobs);
+  for (unsigned t = 0; t < jobs; t++) pool.emplace_back(worker);
+  for (auto &t : pool) t.join();
+}
+
+}  // namespace
+
+void FleetAggregator::add(TraceOrder order, int64_t startedAtMs,
+                          std::span<const FleetFinding> findings) {
+  // Fold the trace's findings per group first, so each group is locked once
+  // per trace and its `traces` counter sees the trace once.
+  struct Local {
+    const FleetFinding *first = nullptr;
+    std::string host;
+    std::string_view endpoint;
+    uint64_t count = 0;
+    std::vector<std::pair<size_t, std::string_view>> evidence;  // (position, text)
+  };
+  std::unordered_map<std::string, Local> local;
+  std::string key;
+  for (size_t i = 0; i < findings.size(); i++) {
+    const FleetFinding &f = findings[i];
+    const UrlView url(f.evidence);
+    std::string host;
+    std::string_view endpoint;
+    if (!url.scheme.empty() && !url.host.empty()) {
+      for (char c : url.host) host.push_back(ascii::lower(c));
+      endpoint = url.path.empty() ? std::string_view("/") : url.path;
+    }
+    key.assign(f.id).append(1, '\0').append(host).append(1, '\0').append(endpoint);
+
+    Local &l = local[key];
+    if (!l.first) {
+      l.first = &f;
+      l.host = std::move(host);
+      l.endpoint = endpoint;
+    }
+    l.count += f.count;
+    if (l.evidence.size() < samples_ && !f.evidence.empty() &&
+        std::none_of(l.evidence.begin(), l.evidence.end(),
+                     [&](const auto &e) { return e.second == f.evidence; })) {
+      l.evidence.emplace_back(i, f.evidence);
+    }
+  }
+
+  for (auto &[k, l] : local) {
+    Shard &shard = shards_[std::hash<std::string>{}(k) % kShards];
+    std::lock_guard lock(shard.mu);
+    auto [it, inserted] = shard.groups.try_emplace(k);
+    Group &g = it->second;
+    if (inserted) {
+      g.id = l.first->id;
+      g.severity = l.first->severity;
+      g.confidence = l.first->confidence;
+      g.title = l.first->title;
+      g.host = l.host;
+      g.endpoint = l.endpoint;
+      g.firstSeenMs = std::numeric_limits<int64_t>::max();
+      g.lastSeenMs = std::numeric_limits<int64_t>::min();
+    }
+    g.count += l.count;
+    g.traces++;
+    g.firstSeenMs = std::min(g.firstSeenMs, startedAtMs);
+    g.lastSeenMs = std::max(g.lastSeenMs, startedAtMs);
+    for (const auto &[position, evidence] : l.evidence) {
+      addSample(g, {order, position, std::string(evidence)});
+    }
+  }
+}
+
+void FleetAggregator::addSample(Group &g, Sample s) const {
+  auto before = [](const Sample &a, const Sample &b) {
+    return std::tie(a.order, a.position) < std::tie(b.order, b.position);
+  };
+  auto same = std::find_if(g.samples.begin(), g.samples.end(),
+                           [&](const Sample &cur) { return cur.evidence == s.evidence; });
+  if (same != g.samples.end()) {
+    if (!before(s, *same)) return;
+    g.samples.erase(same);
+  } else if (g.samples.size() >= samples_ && !before(s, g.samples.back())) {
+    return;
+  }
+  g.samples.insert(std::upper_bound(g.samples.begin(), g.samples.end(), s, before), std::move(s));
+  if (g.samples.size() > samples_) g.samples.pop_back();
+}
+
+size_t FleetAggregator::groupCount() const {
+  size_t n = 0;
+  for (const auto &shard : shards_) {
+    std::lock_guard lock(shard.mu);
+    n += shard.groups.size();
+  }
+  return n;
+}
+
+json FleetAggregator::groupsJson() const {
+  std::vector<const Group *> all;
+  for (const auto &shard : shards_) {
+    std::lock_guard lock(shard.mu);
+    for (const auto &[k, g] : shard.groups) all.push_back(&g);
+  }
+  std::sort(all.begin(), all.end(), [](const Group *a, const Group *b) {
+    if (a->count != b->count) return a->count > b->count;
+    return std::tie(a->id, a->host, a->endpoint) < std::tie(b->id, b->host, b->endpoint);
+  });
+
+  json out = json::array();
+  for (const Group *g : all) {
+    json evidence = json::array();
+    for (const auto &s : g->samples) evidence.push_back(s.evidence);
+    out.push_back({{"id", g->id},
+                   {"severity", g->severity},
+                   {"confidence", g->confidence},
+                   {"title", g->title},
+                   {"host", g->host},
+                   {"endpoint", g->endpoint},
+                   {"count", g->count},
+                   {"traces", g->traces},
+                   {"firstSeenMs", g->firstSeenMs},
+                   {"lastSeenMs", g->lastSeenMs},
+                   {"evidence", std::move(evidence)}});
+  }
+  return out;
+}
+
+int runFleet(const FleetOptions &opts) {
+  std::vector<std::string> inputs;
+  try {
+    inputs = expandBatchInputs(opts.inputs);
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << "\n";
+    return 1;
+  }
+  if (inputs.empty()) {
+    std::cerr << "No traces or reports matched the aggregate inputs.\n";
+    return 1;
+  }
+
+  const unsigned jobs = opts.jobs ? opts.jobs : std::max(1u, std::thread::hardware_concurrency());
+  std::vector<std::string> errors(inputs.size());
+
+  // Inputs are opened first so every tab of a pack becomes its own item.
+  std::vector<std::vector<WorkItem>> perInput(inputs.size());
+  parallelFor(inputs.size(), jobs, [&](size_t i) {
+    try {
+      perInput[i] = workItems(inputs[i], i);
+    } catch (const std::exception &e) {
+      errors[i] = e.what();
+    }
+  });
+  std::vector<WorkItem> items;
+  for (auto &list : perInput) {
+    items.insert(items.end(), std::make_move_iterator(list.begin()),
+                 std::make_move_iterator(list.end()));
+    list = {};
+  }
+
+  FleetAggregator agg(opts.samples);
+  std::vector<std::string> itemErrors(items.size());
+  std::atomic<size_t> traces{0};
+  parallelFor(items.size(), jobs, [&](size_t i) {
+    const WorkItem &item = items[i];
+    try {
+      traces += aggregateItem(inputs[item.order.input], item, agg);
+    } catch (const std::exception &e) {
+      itemErrors[i] = e.what();
+      if (item.pack) {
+        const int tabId = item.pack->reader->meta(item.order.tab).tabId;
+        itemErrors[i] = "tab " + std::to_string(tabId) + ": " + itemErrors[i];
+      }
+    }
+  });
+  // An input reports its first failing item.
+  for (size_t i = 0; i < items.size(); i++) {
+    std::string &error = errors[items[i].order.input];
+    if (!itemErrors[i].empty() && error.empty()) error = std::move(itemErrors[i]);
+  }
+
+  int failed = 0;
+  json failures = json::array();
+  for (size_t i = 0; i < inputs.size(); i++) {
+    if (errors[i].empty()) continue;
+    failed++;
+    failures.push_back({{"input", inputs[i]}, {"error", errors[i]}});
+    std::cerr << inputs[i] << ": " << errors[i] << "\n";
+  }
+
+  json groups = agg.groupsJson();
+  SeverityCounts counts;
+  for (const auto &g : groups) {
+    const auto &severity = g["severity"].get_ref<const std::string &>();
+    if (severity == "HIGH") counts.high++;
+    else if (severity == "MED") counts.med++;
+    else counts.low++;
+  }
+  json fleet = {{"version", 1},
+                {"traces", traces.load()},
+                {"failed", failed},
+                {"failures", failures},
+                {"summary", summaryJson(counts)},
+                {"groups", std::move(groups)}};
+  try {
+    writeJsonFile(opts.outPath, fleet, opts.compact);
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << "\n";
+    return 1;
+  }
+
+  std::cout << "Fleet: " << traces.load() << " traces, " << agg.groupCount() << " groups (HIGH="
+            << counts.high << " MED=" << counts.med << " LOW=" << counts.low << ")\n";
+  std::cout << "Wrote: " << opts.outPath << "\n";
+  return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <compare>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "third_party/json.hpp"
+
+// One finding of one trace, as read from a fresh analysis or a saved report.
+struct FleetFinding {
+  std::string_view id;
+  std::string_view severity;
+  std::string_view confidence;
+  std::string_view title;
+  std::string_view evidence;
+  uint64_t count = 1;
+};
+
+// Where a trace sits among the inputs: the input's position, then the tab's
+// position within a pack (0 for anything else).
+struct TraceOrder {
+  size_t input = 0;
+  size_t tab = 0;
+
+  auto operator<=>(const TraceOrder &) const = default;
+};
+
+// Findings of many traces grouped by (rule id, host, endpoint). Host and
+// endpoint (the path) come from the evidence when it is a URL; findings
+// quoting anything else, such as a Set-Cookie header, group per rule.
+//
+// add() may be called from many threads: groups live in shards picked by
+// key hash, each behind its own mutex. Memory grows with the number of
+// distinct groups, not with traces, since a group keeps only its counters
+// and at most `samples` distinct evidence strings. Samples are the ones
+// seen first in input order, so the result does not depend on scheduling.
+class FleetAggregator {
+ public:
+  explicit FleetAggregator(size_t samples = 3) : samples_(samples) {}
+
+  // The findings of one trace. `order` ranks the trace for sample selection
+  // and `startedAtMs` is its start time (first/last seen).
+  void add(TraceOrder order, int64_t startedAtMs, std::span<const FleetFinding> findings);
+
+  size_t groupCount() const;
+  // Groups by descending count, then id, host and endpoint.
+  nlohmann::json groupsJson() const;
+
+ private:
+  struct Sample {
+    TraceOrder order;
+    size_t position;  // finding position within the trace
+    std::string evidence;
+  };
+  struct Group {
+    std::string id, severity, confidence, title, host, endpoint;
+    uint64_t count = 0;
+    uint64_t traces = 0;
+    int64_t firstSeenMs = 0;
+    int64_t lastSeenMs = 0;
+    std::vector<Sample> samples;  // sorted by (order, position)
+  };
+  struct Shard {
+    mutable std::mutex mu;
+    std::unordered_map<std::string, Group> groups;  // key: id \0 host \0 endpoint
+  };
+  static constexpr size_t kShards = 64;
+
+  void addSample(Group &g, Sample s) const;
+
+  size_t samples_;
+  std::array<Shard, kShards> shards_;
+};
+
+struct FleetOptions {
+  // Traces (JSON or packs; every tab of a pack counts as a trace) and reports
+  // written by `analyze`, in any mix. Expanded like analyze-batch inputs.
+  std::vector<std::string> inputs;
+  std::string outPath = "fleet.json";
+  unsigned jobs = 0;     // 0 picks std::thread::hardware_concurrency()
+  size_t samples = 3;    // evidence samples kept per group
+  bool compact = false;  // unindented output
+};
+
+// Aggregates every input into one fleet report. Each JSON trace or report,
+// and each tab of a pack, is a separate work item, so one large pack is
+// spread over all workers. Returns the process exit code: non-zero if any
+// input failed.
+int runFleet(const FleetOptions &opts);
@@ -0,0 +1,164 @@
+#include "flows.hpp"
+
+#include <stdexcept>
+
+#include "rules.hpp"
+
+static FlowRole roleOf(const EventContext &ctx) {
+  if (ctx.endpoint & kEndpointAuthorize) return FlowRole::Authorize;
+  if (ctx.endpoint & kEndpointToken) return FlowRole::Token;
+  if (ctx.query.has("code") || ctx.query.has("state") || ctx.fragment.has("code") ||
+      ctx.fragment.has("state")) {
+    return FlowRole::Callback;
+  }
+  return FlowRole::None;
+}
+
+void FlowTracker::correlate(EventContext &ctx) {
+  ctx.role = roleOf(ctx);
+  ctx.flow = -1;
+  ctx.flowInfo = nullptr;
+
+  const std::string_view requestId = ctx.ev.requestId;
+  if (!requestId.empty()) {
+    auto it = byRequestId_.find(requestId);
+    if (it != byRequestId_.end()) ctx.flow = it->second;
+  }
+
+  if (ctx.flow < 0) {
+    switch (ctx.role) {
+      case FlowRole::Authorize:
+        ctx.flow = openFlow(ctx);
+        break;
+      case FlowRole::Callback: {
+        auto state = ctx.query.get("state");
+        if (!state) state = ctx.fragment.get("state");
+        ctx.flow = matchCallback(state);
+        break;
+      }
+      case FlowRole::Token:
+        ctx.flow = matchToken(ctx.url.host);
+        break;
+      case FlowRole::None:
+        return;
+    }
+    if (!requestId.empty()) byRequestId_.emplace(requestId, ctx.flow);
+  }
+
+  Flow &f = flows_[static_cast<size_t>(ctx.flow)];
+  if (ctx.role == FlowRole::Callback) f.sawCallback = true;
+  if (ctx.role == FlowRole::Token) f.sawToken = true;
+  ctx.flowInfo = &f;
+}
+
+int FlowTracker::openFlow(const EventContext &ctx) {
+  auto clientId = ctx.query.get("client_id");
+  auto state = ctx.query.get("state");
+  std::string key(ctx.url.host);
+  key += '\n';
+  key += clientId.value_or("");
+  key += '\n';
+  key += state.value_or("");
+
+  auto [it, inserted] = byKey_.try_emplace(std::move(key), static_cast<int>(flows_.size()));
+  if (!inserted) return it->second;
+
+  Flow f;
+  f.host = std::string(ctx.url.host);
+  f.clientId = clientId.value_or("");
+  f.state = state;
+  f.authorizeUrl = std::string(ctx.ev.url);
+  flows_.push_back(std::move(f));
+
+  const int id = it->second;
+  if (state) {
+    byState_[*state] = id;
+    latestWithState_ = id;
+  }
+  HostFlows &host = byHost_[flows_.back().host];
+  host.latest = id;
+  host.awaitingToken.push_back(id);
+  awaitingCallback_.push_back(id);
+  awaitingToken_.push_back(id);
+  return id;
+}
+
+int FlowTracker::newestWaiting(std::vector<int> &stack, bool Flow::*seen) {
+  while (!stack.empty() && flows_[static_cast<size_t>(stack.back())].*seen) stack.pop_back();
+  return stack.empty() ? -1 : stack.back();
+}
+
+int FlowTracker::matchCallback(const std::optional<std::string> &state) {
+  if (state) {
+    auto it = byState_.find(*state);
+    if (it != byState_.end()) return it->second;
+    // An unknown state is a forged or stale callback, not a new login: keep
+    // it with a flow whose state it can be checked against.
+    if (latestWithState_ >= 0) return latestWithState_;
+  }
+  int id = newestWaiting(awaitingCallback_, &Flow::sawCallback);
+  return id >= 0 ? id : orphan();
+}
+
+int FlowTracker::matchToken(std::string_view host) {
+  auto it = byHost_.find(host);
+  if (it != byHost_.end()) {
+    int id = newestWaiting(it->second.awaitingToken, &Flow::sawToken);
+    return id >= 0 ? id : it->second.latest;
+  }
+  int id = newestWaiting(awaitingToken_, &Flow::sawToken);
+  return id >= 0 ? id : orphan();
+}
+
+int FlowTracker::orphan() {
+  if (orphan_ < 0) {
+    orphan_ = static_cast<int>(flows_.size());
+    Flow f;
+    f.orphan = true;
+    flows_.push_back(std::move(f));
+  }
+  return orphan_;
+}
+
+nlohmann::json FlowTracker::save() const {
+  return {
+      {"flows", flows_},
+      {"byKey", byKey_},
+      {"byState", byState_},
+      {"byHost", byHost_},
+      {"byRequestId", byRequestId_},
+      {"awaitingCallback", awaitingCallback_},
+      {"awaitingToken", awaitingToken_},
+      {"latestWithState", latestWithState_},
+      {"orphan", orphan_},
+  };
+}
+
+void FlowTracker::load(const nlohmann::json &state) {
+  state.at("flows").get_to(flows_);
+  state.at("byKey").get_to(byKey_);
+  state.at("byState").get_to(byState_);
+  state.at("byHost").get_to(byHost_);
+  state.at("byRequestId").get_to(byRequestId_);
+  state.at("awaitingCallback").get_to(awaitingCallback_);
+  state.at("awaitingToken").get_to(awaitingToken_);
+  state.at("latestWithState").get_to(latestWithState_);
+  state.at("orphan").get_to(orphan_);
+
+  // Every index must name a loaded flow; -1 is only valid for "none yet".
+  const int n = static_cast<int>(flows_.size());
+  auto check = [&](int id, bool optional) {
+    if (id >= n || id < (optional ? -1 : 0)) throw std::runtime_error("Invalid flow state.");
+  };
+  for (const auto *index : {&byKey_, &byState_, &byRequestId_}) {
+    for (const auto &[k, id] : *index) check(id, false);
+  }
+  for (const auto &[k, host] : byHost_) {
+    check(host.latest, true);
+    for (int id : host.awaitingToken) check(id, false);
+  }
+  for (int id : awaitingCallback_) check(id, false);
+  for (int id : awaitingToken_) check(id, false);
+  check(latestWithState_, true);
+  check(orphan_, true);
+}
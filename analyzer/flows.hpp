@@ -0,0 +1,90 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "string_hash.hpp"
+#include "third_party/json.hpp"
+
+struct EventContext;
+
+enum class FlowRole { None, Authorize, Callback, Token };
+
+// One login attempt: an authorize request and whatever callback and token
+// exchange could be tied to it.
+struct Flow {
+  std::string host;                  // authorize endpoint host
+  std::string clientId;
+  std::optional<std::string> state;  // state sent on the authorize request
+  std::string authorizeUrl;
+  bool orphan = false;  // collects callback/token events with no authorize
+  bool sawCallback = false;
+  bool sawToken = false;
+
+  NLOHMANN_DEFINE_TYPE_INTRUSIVE(Flow, host, clientId, state, authorizeUrl, orphan, sawCallback,
+                                 sawToken)
+};
+
+// Ties events to flows so cross-event rules can be evaluated per login
+// instead of per trace. Each event is looked up in hash indexes, so
+// correlation is O(1) per event:
+//   - a requestId seen before (request/response pairs) reuses its flow;
+//   - authorize requests open or rejoin the flow keyed by host, client_id
+//     and state;
+//   - callbacks join the flow whose authorize sent the same state; a state no
+//     authorize sent joins the newest flow that sent one, even if it already
+//     had its callback, so the mismatch is checked against it; a callback
+//     without state joins the newest flow still waiting for a callback;
+//   - token requests join the newest flow on the same host still waiting for
+//     a token exchange (or the newest on that host), or else the newest flow
+//     anywhere still waiting for one.
+// "Waiting" lists are stacks popped lazily once a flow is satisfied, so the
+// fallbacks stay amortized O(1) as well.
+// Callbacks and token requests that match nothing share one orphan flow.
+// Only flow-related events are indexed, so memory grows with logins, not
+// with trace length.
+class FlowTracker {
+ public:
+  // Sets ctx.role, ctx.flow and ctx.flowInfo.
+  void correlate(EventContext &ctx);
+
+  const Flow &flow(int id) const { return flows_[static_cast<size_t>(id)]; }
+  size_t size() const { return flows_.size(); }
+
+  // Checkpoint support: the complete correlation state.
+  nlohmann::json save() const;
+  void load(const nlohmann::json &state);
+
+ private:
+  // String-keyed index looked up by std::string_view without a copy.
+  template <typename T>
+  using Index = std::unordered_map<std::string, T, StringHash, std::equal_to<>>;
+
+  struct HostFlows {
+    int latest = -1;
+    std::vector<int> awaitingToken;
+
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE(HostFlows, latest, awaitingToken)
+  };
+
+  int openFlow(const EventContext &ctx);
+  int matchCallback(const std::optional<std::string> &state);
+  int matchToken(std::string_view host);
+  int orphan();
+  // Newest flow on `stack` that has not yet seen `seen`, dropping the ones
+  // that have.
+  int newestWaiting(std::vector<int> &stack, bool Flow::*seen);
+
+  std::vector<Flow> flows_;
+  Index<int> byKey_;
+  Index<int> byState_;
+  Index<HostFlows> byHost_;
+  Index<int> byRequestId_;
+  std::vector<int> awaitingCallback_;
+  std::vector<int> awaitingToken_;
+  int latestWithState_ = -1;
+  int orphan_ = -1;
+};
@@ -0,0 +1,45 @@
+#include "headers.hpp"
+
+void HeaderIndex::Side::build(const std::vector<Header> &headers, std::vector<uint8_t> &ids) {
+  present = 0;
+  start.fill(0);
+  values.clear();
+  if (headers.empty()) return;
+
+  // Counting sort on the recognized name: one recognition per header, then
+  // values are placed so each name's occurrences are contiguous.
+  ids.resize(headers.size());
+  std::array<uint32_t, kNames + 1> count{};
+  for (size_t i = 0; i < headers.size(); i++) {
+    const auto name = headerNameOf(headers[i].name);
+    const auto id = static_cast<uint8_t>(name ? *name : HeaderName::kCount);
+    ids[i] = id;
+    count[id]++;
+  }
+  uint32_t at = 0;
+  for (size_t n = 0; n < kNames; n++) {
+    start[n] = at;
+    at += count[n];
+    if (count[n]) present |= 1u << n;
+  }
+  start[kNames] = at;
+  if (!present) return;
+
+  values.resize(at);
+  std::array<uint32_t, kNames> next{};
+  for (size_t n = 0; n < kNames; n++) next[n] = start[n];
+  for (size_t i = 0; i < headers.size(); i++) {
+    if (ids[i] < kNames) values[next[ids[i]]++] = headers[i].value;
+  }
+}
+
+void HeaderIndex::build(const TraceEvent &ev) {
+  sides_[static_cast<size_t>(HeaderSide::Request)].build(ev.requestHeaders, ids_);
+  sides_[static_cast<size_t>(HeaderSide::Response)].build(ev.responseHeaders, ids_);
+}
+
+std::span<const std::string_view> HeaderIndex::values(HeaderSide side, HeaderName name) const {
+  const Side &s = sides_[static_cast<size_t>(side)];
+  const auto n = static_cast<size_t>(name);
+  return {s.values.data() + s.start[n], s.start[n + 1] - s.start[n]};
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "ascii.hpp"
+#include "trace.hpp"
+
+// Headers rules can ask for by name. Others are not indexed.
+enum class HeaderName : uint8_t {
+  SetCookie,
+  Cookie,
+  Location,
+  WwwAuthenticate,
+  CacheControl,
+  Pragma,
+  ReferrerPolicy,
+  Authorization,
+  Referer,
+  Origin,
+  ContentType,
+  kCount,
+};
+
+enum class HeaderSide : uint8_t { Request, Response };
+
+// Recognizes a header name case-insensitively, switching on its length.
+constexpr std::optional<HeaderName> headerNameOf(std::string_view name) {
+  using ascii::is;
+  switch (name.size()) {
+    case 6:
+      if (is(name, "cookie")) return HeaderName::Cookie;
+      if (is(name, "pragma")) return HeaderName::Pragma;
+      if (is(name, "origin")) return HeaderName::Origin;
+      break;
+    case 7:
+      if (is(name, "referer")) return HeaderName::Referer;
+      break;
+    case 8:
+      if (is(name, "location")) return HeaderName::Location;
+      break;
+    case 10:
+      if (is(name, "set-cookie")) return HeaderName::SetCookie;
+      break;
+    case 12:
+      if (is(name, "content-type")) return HeaderName::ContentType;
+      break;
+    case 13:
+      if (is(name, "cache-control")) return HeaderName::CacheControl;
+      if (is(name, "authorization")) return HeaderName::Authorization;
+      break;
+    case 15:
+      if (is(name, "referrer-policy")) return HeaderName::ReferrerPolicy;
+      break;
+    case 16:
+      if (is(name, "www-authenticate")) return HeaderName::WwwAuthenticate;
+      break;
+  }
+  return std::nullopt;
+}
+
+// The known headers of one event, request and response side, grouped by
+// name. Each header name is recognized once per event however many rules
+// look it up. Both trace shapes (a {name, value} list and a name -> value
+// object) arrive here as TraceEvent header lists. Values are views into the
+// event, in trace order, so repeated headers such as Set-Cookie keep every
+// occurrence. Reused across events by the engine to keep its buffers.
+class HeaderIndex {
+ public:
+  void build(const TraceEvent &ev);
+
+  bool has(HeaderSide side, HeaderName name) const {
+    return (sides_[static_cast<size_t>(side)].present >> static_cast<unsigned>(name)) & 1u;
+  }
+  // Bit per HeaderName present on `side`.
+  uint32_t present(HeaderSide side) const { return sides_[static_cast<size_t>(side)].present; }
+  std::span<const std::string_view> values(HeaderSide side, HeaderName name) const;
+  // The first value, or an empty view if the header is absent.
+  std::string_view first(HeaderSide side, HeaderName name) const {
+    auto v = values(side, name);
+    return v.empty() ? std::string_view() : v.front();
+  }
+
+ private:
+  static constexpr size_t kNames = static_cast<size_t>(HeaderName::kCount);
+
+  struct Side {
+    uint32_t present = 0;
+    std::array<uint32_t, kNames + 1> start{};  // values_ range per name
+    std::vector<std::string_view> values;
+
+    void build(const std::vector<Header> &headers, std::vector<uint8_t> &ids);
+  };
+
+  std::array<Side, 2> sides_;
+  std::vector<uint8_t> ids_;  // scratch: HeaderName per header, or kCount
+};
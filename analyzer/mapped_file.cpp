@@ -0,0 +1,32 @@
+#include "mapped_file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::~MappedFile() {
+  if (addr_) ::munmap(addr_, size_);
+}
+
+bool MappedFile::open(const std::string &path) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+
+  struct stat st {};
+  if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+    ::close(fd);
+    return false;
+  }
+
+  void *addr = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (addr == MAP_FAILED) return false;
+#ifdef MADV_SEQUENTIAL
+  ::madvise(addr, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+#endif
+
+  addr_ = addr;
+  size_ = static_cast<size_t>(st.st_size);
+  return true;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Read-only memory mapping of a whole file. Empty and non-regular files
+// (pipes, character devices) cannot be mapped; open() reports false for them
+// so callers can fall back to stream input.
+class MappedFile {
+ public:
+  MappedFile() = default;
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  bool open(const std::string &path);
+  std::string_view data() const {
+    return {static_cast<const char *>(addr_), size_};
+  }
+
+ private:
+  void *addr_ = nullptr;
+  size_t size_ = 0;
+};
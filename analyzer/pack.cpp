@@ -0,0 +1,304 @@
+#include "pack.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+
+namespace {
+
+constexpr char kMagic[4] = {'A', 'L', 'P', 'K'};
+constexpr size_t kHeaderSize = 8;
+constexpr size_t kTrailerSize = 20;
+constexpr size_t kIndexEntrySize = 16;
+constexpr size_t kTabRecordSize = 36;
+
+constexpr uint32_t kTabTruncated = 1u << 0;
+constexpr uint32_t kTabSorted = 1u << 1;
+
+void put32(std::string &out, uint32_t v) {
+  for (int i = 0; i < 4; i++) out.push_back(static_cast<char>(v >> (8 * i)));
+}
+
+void put64(std::string &out, uint64_t v) {
+  for (int i = 0; i < 8; i++) out.push_back(static_cast<char>(v >> (8 * i)));
+}
+
+uint32_t get32(const char *p) {
+  uint32_t v = 0;
+  for (int i = 0; i < 4; i++) {
+    v |= static_cast<uint32_t>(static_cast<unsigned char>(p[i])) << (8 * i);
+  }
+  return v;
+}
+
+uint64_t get64(const char *p) {
+  return get32(p) | (static_cast<uint64_t>(get32(p + 4)) << 32);
+}
+
+[[noreturn]] void invalid(const char *what) {
+  throw std::runtime_error(std::string("Invalid pack: ") + what);
+}
+
+// Bounds-checked little-endian reader over one region of the pack.
+class Cursor {
+ public:
+  Cursor(const char *p, const char *end) : p_(p), end_(end) {}
+
+  uint32_t u32() { return get32(take(4)); }
+  uint64_t u64() { return get64(take(8)); }
+  int32_t i32() { return static_cast<int32_t>(u32()); }
+  int64_t i64() { return static_cast<int64_t>(u64()); }
+  const char *take(uint64_t n) {
+    if (n > static_cast<uint64_t>(end_ - p_)) invalid("truncated record");
+    const char *p = p_;
+    p_ += n;
+    return p;
+  }
+
+ private:
+  const char *p_;
+  const char *end_;
+};
+
+}  // namespace
+
+bool isPack(std::string_view data) {
+  return data.size() >= sizeof(kMagic) && std::memcmp(data.data(), kMagic, sizeof(kMagic)) == 0;
+}
+
+// ---- Writer ------------------------------------------------------------------
+
+PackWriter::PackWriter(std::ostream &out) : out_(out) {
+  strings_.push_back({});
+  ids_.emplace(std::string(), 0);
+  buf_.assign(kMagic, sizeof(kMagic));
+  put32(buf_, kPackFormatVersion);
+  write(buf_);
+}
+
+void PackWriter::write(const std::string &bytes) {
+  out_.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+  if (!out_) throw std::runtime_error("Failed to write pack output.");
+  offset_ += bytes.size();
+}
+
+uint32_t PackWriter::intern(std::string_view s) {
+  auto [it, inserted] = ids_.try_emplace(std::string(s), static_cast<uint32_t>(strings_.size()));
+  if (inserted) strings_.push_back(it->first);
+  return it->second;
+}
+
+void PackWriter::beginTab() { tabs_.emplace_back(); }
+
+void PackWriter::add(const TraceEvent &ev) {
+  buf_.clear();
+  put32(buf_, 0);  // payload length, patched below
+  put64(buf_, static_cast<uint64_t>(ev.tMs));
+  put32(buf_, static_cast<uint32_t>(ev.status));
+  put32(buf_, ev.hasRequestBodyKeys ? 1u : 0u);
+  for (auto s : {ev.type, ev.requestId, ev.method, ev.url, ev.initiator}) put32(buf_, intern(s));
+  put32(buf_, static_cast<uint32_t>(ev.requestBodyKeys.size()));
+  for (auto k : ev.requestBodyKeys) put32(buf_, intern(k));
+  for (const auto *headers : {&ev.requestHeaders, &ev.responseHeaders}) {
+    put32(buf_, static_cast<uint32_t>(headers->size()));
+    for (const auto &h : *headers) {
+      put32(buf_, intern(h.name));
+      put32(buf_, intern(h.value));
+    }
+  }
+  const auto payload = static_cast<uint32_t>(buf_.size() - 4);
+  for (int i = 0; i < 4; i++) buf_[i] = static_cast<char>(payload >> (8 * i));
+
+  tabs_.back().events.push_back({ev.tMs, offset_});
+  write(buf_);
+}
+
+void PackWriter::endTab(const TraceMeta &meta) { tabs_.back().meta = meta; }
+
+void PackWriter::finish() {
+  const uint64_t stringsOffset = offset_;
+  buf_.clear();
+  put32(buf_, static_cast<uint32_t>(strings_.size()));
+  uint64_t at = stringsOffset + 4 + 8 * static_cast<uint64_t>(strings_.size());
+  for (auto s : strings_) {
+    put64(buf_, at);
+    at += 4 + s.size();
+  }
+  for (auto s : strings_) {
+    put32(buf_, static_cast<uint32_t>(s.size()));
+    buf_.append(s);
+  }
+  write(buf_);
+
+  const uint64_t indexOffset = offset_;
+  buf_.clear();
+  put32(buf_, static_cast<uint32_t>(tabs_.size()));
+  uint64_t entries = indexOffset + 4 + (kTabRecordSize + 4) * static_cast<uint64_t>(tabs_.size());
+  for (const auto &tab : tabs_) {
+    const bool sorted = std::is_sorted(tab.events.begin(), tab.events.end(),
+                                       [](const auto &a, const auto &b) { return a.tMs < b.tMs; });
+    put32(buf_, static_cast<uint32_t>(tab.meta.version));
+    put32(buf_, static_cast<uint32_t>(tab.meta.tabId));
+    put64(buf_, static_cast<uint64_t>(static_cast<int64_t>(tab.meta.startedAtMs)));
+    put32(buf_, static_cast<uint32_t>(tab.meta.droppedEvents));
+    put32(buf_, (tab.meta.truncated ? kTabTruncated : 0) | (sorted ? kTabSorted : 0));
+    put32(buf_, static_cast<uint32_t>(tab.events.size()));
+    put64(buf_, entries);
+    entries += kIndexEntrySize * tab.events.size();
+  }
+  std::vector<uint32_t> byId(tabs_.size());
+  std::iota(byId.begin(), byId.end(), 0u);
+  std::stable_sort(byId.begin(), byId.end(), [&](uint32_t a, uint32_t b) {
+    return tabs_[a].meta.tabId < tabs_[b].meta.tabId;
+  });
+  for (uint32_t pos : byId) put32(buf_, pos);
+  for (const auto &tab : tabs_) {
+    for (const auto &e : tab.events) {
+      put64(buf_, static_cast<uint64_t>(e.tMs));
+      put64(buf_, e.offset);
+    }
+  }
+  put64(buf_, stringsOffset);
+  put64(buf_, indexOffset);
+  buf_.append(kMagic, sizeof(kMagic));
+  write(buf_);
+  out_.flush();
+  if (!out_) throw std::runtime_error("Failed to write pack output.");
+}
+
+// ---- Reader ------------------------------------------------------------------
+
+PackReader::PackReader(std::string_view data) : data_(data) {
+  if (data.size() < kHeaderSize + kTrailerSize || !isPack(data) ||
+      std::memcmp(data.data() + data.size() - sizeof(kMagic), kMagic, sizeof(kMagic)) != 0) {
+    invalid("missing header or trailer");
+  }
+  if (get32(data.data() + 4) != kPackFormatVersion) invalid("unsupported format version");
+
+  const char *trailer = data.data() + data.size() - kTrailerSize;
+  const uint64_t stringsOffset = get64(trailer);
+  indexOffset_ = get64(trailer + 8);
+  trailerOffset_ = data.size() - kTrailerSize;
+  if (stringsOffset < kHeaderSize || stringsOffset > indexOffset_ ||
+      indexOffset_ > trailerOffset_) {
+    invalid("bad section offsets");
+  }
+  eventsEnd_ = stringsOffset;
+
+  Cursor strings(data.data() + stringsOffset, data.data() + indexOffset_);
+  stringCount_ = strings.u32();
+  if (stringCount_ == 0) invalid("bad string table");
+  stringOffsets_ = strings.take(8 * static_cast<uint64_t>(stringCount_));
+  stringsBegin_ = static_cast<uint64_t>(stringOffsets_ - data.data()) + 8 * stringCount_;
+
+  Cursor index(data.data() + indexOffset_, trailer);
+  tabCount_ = index.u32();
+  tabRecords_ = index.take(kTabRecordSize * tabCount_);
+  tabsById_ = index.take(4 * static_cast<uint64_t>(tabCount_));
+}
+
+const char *PackReader::tabRecord(size_t tab) const {
+  if (tab >= tabCount_) throw std::out_of_range("pack tab out of range");
+  return tabRecords_ + tab * kTabRecordSize;
+}
+
+TraceMeta PackReader::meta(size_t tab) const {
+  Cursor c(tabRecord(tab), tabRecord(tab) + kTabRecordSize);
+  TraceMeta meta;
+  meta.version = c.i32();
+  meta.tabId = c.i32();
+  meta.startedAtMs = c.i64();
+  meta.droppedEvents = c.i32();
+  meta.truncated = (c.u32() & kTabTruncated) != 0;
+  return meta;
+}
+
+size_t PackReader::findTab(int tabId) const {
+  auto positionAt = [&](size_t i) {
+    const uint32_t pos = get32(tabsById_ + 4 * i);
+    if (pos >= tabCount_) invalid("tab position out of range");
+    return pos;
+  };
+  auto tabIdAt = [&](size_t i) {
+    return static_cast<int32_t>(get32(tabRecord(positionAt(i)) + 4));
+  };
+  size_t lo = 0, hi = tabCount_;
+  while (lo < hi) {
+    const size_t mid = lo + (hi - lo) / 2;
+    if (tabIdAt(mid) < tabId) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo < tabCount_ && tabIdAt(lo) == tabId ? positionAt(lo) : tabCount_;
+}
+
+std::string_view PackReader::str(uint32_t id) const {
+  if (id >= stringCount_) invalid("string id out of range");
+  const uint64_t offset = get64(stringOffsets_ + 8 * static_cast<size_t>(id));
+  if (offset < stringsBegin_ || offset > indexOffset_ - 4) invalid("string offset out of range");
+  const uint32_t len = get32(data_.data() + offset);
+  if (len > indexOffset_ - offset - 4) invalid("string out of range");
+  return {data_.data() + offset + 4, len};
+}
+
+void PackReader::decode(uint64_t offset, TraceEvent &ev) const {
+  ev.clear();
+  Cursor rec(data_.data() + offset, data_.data() + eventsEnd_);
+  const uint32_t payload = rec.u32();
+  const char *begin = rec.take(payload);
+  Cursor c(begin, begin + payload);
+  ev.tMs = c.i64();
+  ev.status = c.i32();
+  ev.hasRequestBodyKeys = (c.u32() & 1) != 0;
+  ev.type = str(c.u32());
+  ev.requestId = str(c.u32());
+  ev.method = str(c.u32());
+  ev.url = str(c.u32());
+  ev.initiator = str(c.u32());
+  for (uint32_t n = c.u32(); n > 0; n--) ev.requestBodyKeys.push_back(str(c.u32()));
+  for (auto *headers : {&ev.requestHeaders, &ev.responseHeaders}) {
+    for (uint32_t n = c.u32(); n > 0; n--) {
+      const std::string_view name = str(c.u32());
+      headers->push_back({name, str(c.u32())});
+    }
+  }
+}
+
+void PackReader::read(size_t tab, const EventSink &sink, const TimeWindow &window) const {
+  const char *record = tabRecord(tab);
+  const bool sorted = (get32(record + 20) & kTabSorted) != 0;
+  const uint32_t eventCount = get32(record + 24);
+  const uint64_t entries = get64(record + 28);
+  if (entries < indexOffset_ || entries > trailerOffset_ ||
+      kIndexEntrySize * static_cast<uint64_t>(eventCount) > trailerOffset_ - entries) {
+    invalid("event index out of range");
+  }
+  const char *index = data_.data() + entries;
+  auto tMsAt = [&](uint32_t i) {
+    return static_cast<int64_t>(get64(index + static_cast<size_t>(i) * kIndexEntrySize));
+  };
+
+  uint32_t first = 0;
+  if (sorted) {
+    uint32_t lo = 0, hi = eventCount;
+    while (lo < hi) {
+      const uint32_t mid = lo + (hi - lo) / 2;
+      if (tMsAt(mid) < window.lo) lo = mid + 1;
+      else hi = mid;
+    }
+    first = lo;
+  }
+
+  TraceEvent ev;
+  for (uint32_t i = first; i < eventCount; i++) {
+    const int64_t tMs = tMsAt(i);
+    if (!window.contains(tMs)) {
+      if (sorted) break;
+      continue;
+    }
+    const uint64_t offset = get64(index + static_cast<size_t>(i) * kIndexEntrySize + 8);
+    if (offset < kHeaderSize || offset >= eventsEnd_) invalid("event offset out of range");
+    decode(offset, ev);
+    sink(ev);
+  }
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "trace.hpp"
+
+// authlens pack: a binary container for one or more traces (one per tab)
+// that re-analysis can read without tokenizing JSON.
+//
+// All integers are little-endian. Layout:
+//
+//   header   "ALPK" u32 formatVersion
+//   events   per event: u32 payloadLength, payload
+//              i64 tMs, i32 status, u32 flags (bit 0: hasRequestBodyKeys),
+//              u32 string ids for type, requestId, method, url, initiator,
+//              u32 n + n ids         requestBodyKeys
+//              u32 n + n id pairs    requestHeaders (name, value)
+//              u32 n + n id pairs    responseHeaders (name, value)
+//   strings  u32 count, count x u64 string offset,
+//            per string u32 length + bytes; id 0 is ""
+//   index    u32 tabCount,
+//            tabCount x tab record (in input order):
+//              i32 version, i32 tabId, i64 startedAtMs, i32 droppedEvents,
+//              u32 flags (bit 0: truncated, bit 1: tMs ascending),
+//              u32 eventCount, u64 offset of the tab's event entries
+//            tabCount x u32 tab position, ordered by (tabId, position)
+//            per tab: eventCount x (i64 tMs, u64 event offset)
+//   trailer  u64 stringsOffset, u64 indexOffset, "ALPK"
+//
+// Every table is fixed-width, so a reader opens a pack in constant time and
+// reaches a string, a tab or an event without touching the rest.
+//
+// Only fields the analyzer keeps in TraceEvent/TraceMeta are stored, so a
+// packed trace analyzes to exactly the report of its JSON source.
+
+constexpr uint32_t kPackFormatVersion = 2;
+
+// True if `data` starts with the pack magic.
+bool isPack(std::string_view data);
+
+// Writes a pack to `out`. Call beginTab(), add() each event, endTab() with
+// the trace's metadata, repeat per trace, then finish(). Throws
+// std::runtime_error if the stream fails.
+class PackWriter {
+ public:
+  explicit PackWriter(std::ostream &out);
+
+  void beginTab();
+  void add(const TraceEvent &ev);
+  void endTab(const TraceMeta &meta);
+  void finish();
+
+ private:
+  struct IndexEntry {
+    int64_t tMs;
+    uint64_t offset;
+  };
+  struct Tab {
+    TraceMeta meta;
+    std::vector<IndexEntry> events;
+  };
+
+  uint32_t intern(std::string_view s);
+  void write(const std::string &bytes);
+
+  std::ostream &out_;
+  uint64_t offset_ = 0;
+  std::vector<std::string_view> strings_;  // views of the map's keys
+  std::unordered_map<std::string, uint32_t> ids_;
+  std::vector<Tab> tabs_;
+  std::string buf_;
+};
+
+// Events with lo <= tMs <= hi.
+struct TimeWindow {
+  int64_t lo = std::numeric_limits<int64_t>::min();
+  int64_t hi = std::numeric_limits<int64_t>::max();
+
+  bool contains(int64_t t) const { return t >= lo && t <= hi; }
+};
+
+// Reads a pack held in memory (typically a MappedFile). Strings handed to
+// sinks are views into `data`, which must outlive the reader. Opening checks
+// the header, trailer and table sizes only; tab records, event entries and
+// string ids are validated as they are used. Throws std::runtime_error on a
+// malformed pack.
+class PackReader {
+ public:
+  explicit PackReader(std::string_view data);
+
+  size_t tabCount() const { return tabCount_; }
+  TraceMeta meta(size_t tab) const;
+  // Position of the first tab with this tabId, or tabCount() if absent.
+  // Binary search over the tabId table.
+  size_t findTab(int tabId) const;
+
+  // Streams the tab's events, in trace order, to `sink`. When the tab's
+  // timestamps are ascending the window is located by binary search over
+  // the index; otherwise every event is checked.
+  void read(size_t tab, const EventSink &sink, const TimeWindow &window = {}) const;
+
+ private:
+  const char *tabRecord(size_t tab) const;
+  void decode(uint64_t offset, TraceEvent &ev) const;
+  std::string_view str(uint32_t id) const;
+
+  std::string_view data_;
+  uint64_t eventsEnd_ = 0;     // == strings section offset
+  uint64_t stringsBegin_ = 0;  // first string record, after the offset table
+  uint64_t indexOffset_ = 0;
+  uint64_t trailerOffset_ = 0;
+  const char *stringOffsets_ = nullptr;
+  uint32_t stringCount_ = 0;
+  const char *tabRecords_ = nullptr;
+  const char *tabsById_ = nullptr;
+  uint32_t tabCount_ = 0;
+};
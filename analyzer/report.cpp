@@ -0,0 +1,224 @@
+#include "report.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+
+using json = nlohmann::json;
+
+void SeverityCounts::add(const Finding &f) {
+  if (f.rule->severity == "HIGH") high++;
+  else if (f.rule->severity == "MED") med++;
+  else low++;
+}
+
+void SeverityCounts::add(const SeverityCounts &other) {
+  high += other.high;
+  med += other.med;
+  low += other.low;
+}
+
+SeverityCounts countSeverities(const FindingSet &findings) {
+  SeverityCounts c;
+  for (const auto &f : findings) c.add(f);
+  return c;
+}
+
+json summaryJson(const SeverityCounts &counts) {
+  return {{"HIGH", counts.high}, {"MED", counts.med}, {"LOW", counts.low}};
+}
+
+json findingJson(const Finding &f) {
+  const RuleInfo &r = *f.rule;
+  json j = {
+      {"id", r.id},
+      {"severity", r.severity},
+      {"confidence", r.confidence},
+      {"title", r.title},
+      {"why", r.why},
+      {"fix", r.fix},
+      {"evidence", json::array()},
+  };
+  if (!f.evidence.empty()) j["evidence"].push_back(f.evidence);
+  if (f.count > 1) j["count"] = f.count;
+  return j;
+}
+
+namespace {
+
+// Hand-rolled writer for the fixed report schema. Keys are emitted in the
+// sorted order nlohmann::json uses for objects, and whitespace follows its
+// dump() rules, so existing consumers and goldens see identical bytes.
+class ReportStream {
+ public:
+  ReportStream(std::ostream &out, bool compact) : out_(out), compact_(compact) {}
+
+  void open(char bracket) {
+    out_.put(bracket);
+    depth_++;
+    first_ = true;
+  }
+  void close(char bracket) {
+    depth_--;
+    if (!first_) newline();
+    out_.put(bracket);
+    first_ = false;
+  }
+  void key(std::string_view k) {
+    next();
+    string(k);
+    out_ << (compact_ ? ":" : ": ");
+  }
+  void element() { next(); }
+
+  void string(std::string_view s) {
+    // Plain printable ASCII is the common case and is written as is; anything
+    // else goes through nlohmann's serializer for identical escaping and the
+    // same error on invalid UTF-8.
+    for (unsigned char c : s) {
+      if (c < 0x20 || c >= 0x80 || c == '"' || c == '\\') {
+        out_ << json(s).dump();
+        return;
+      }
+    }
+    out_.put('"');
+    out_.write(s.data(), static_cast<std::streamsize>(s.size()));
+    out_.put('"');
+  }
+  void number(int64_t n) { out_ << n; }
+
+ private:
+  void next() {
+    if (!first_) out_.put(',');
+    first_ = false;
+    newline();
+  }
+  void newline() {
+    if (compact_) return;
+    out_.put('\n');
+    for (int i = 0; i < depth_; i++) out_ << "  ";
+  }
+
+  std::ostream &out_;
+  bool compact_;
+  int depth_ = 0;
+  bool first_ = true;
+};
+
+void writeFinding(ReportStream &w, const Finding &f) {
+  const RuleInfo &r = *f.rule;
+  w.open('{');
+  w.key("confidence");
+  w.string(r.confidence);
+  if (f.count > 1) {
+    w.key("count");
+    w.number(f.count);
+  }
+  w.key("evidence");
+  w.open('[');
+  if (!f.evidence.empty()) {
+    w.element();
+    w.string(f.evidence);
+  }
+  w.close(']');
+  w.key("fix");
+  w.string(r.fix);
+  w.key("id");
+  w.string(r.id);
+  w.key("severity");
+  w.string(r.severity);
+  w.key("title");
+  w.string(r.title);
+  w.key("why");
+  w.string(r.why);
+  w.close('}');
+}
+
+}  // namespace
+
+void writeReport(std::ostream &out, const TraceMeta &meta, const FindingSet &findings,
+                 bool compact) {
+  ReportStream w(out, compact);
+  SeverityCounts counts;
+
+  w.open('{');
+  w.key("findings");
+  w.open('[');
+  for (const auto &f : findings) {
+    counts.add(f);
+    w.element();
+    writeFinding(w, f);
+  }
+  w.close(']');
+  w.key("startedAtMs");
+  w.number(meta.startedAtMs);
+  w.key("summary");
+  w.open('{');
+  w.key("HIGH");
+  w.number(counts.high);
+  w.key("LOW");
+  w.number(counts.low);
+  w.key("MED");
+  w.number(counts.med);
+  w.close('}');
+  w.key("tabId");
+  w.number(meta.tabId);
+  w.key("version");
+  w.number(1);
+  w.close('}');
+}
+
+namespace {
+
+// Writes `path` through a temporary file renamed over it, so a failure
+// partway through (e.g. a string that cannot be serialized) leaves the
+// previous file, or none, rather than a truncated one. Paths that exist but
+// are not regular files (/dev/stdout, a fifo) are written directly.
+template <typename WriteFn>
+void replaceFile(const std::string &path, WriteFn &&write) {
+  std::error_code ec;
+  const auto status = std::filesystem::status(path, ec);
+  if (std::filesystem::exists(status) && !std::filesystem::is_regular_file(status)) {
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error("Failed to open output file: " + path);
+    write(out);
+    out.flush();
+    if (!out) throw std::runtime_error("Failed to write output file: " + path);
+    return;
+  }
+
+  const std::string tmp = path + ".tmp";
+  try {
+    std::ofstream out(tmp);
+    if (!out) throw std::runtime_error("Failed to open output file: " + path);
+    write(out);
+    out.flush();
+    if (!out) throw std::runtime_error("Failed to write output file: " + path);
+  } catch (...) {
+    std::remove(tmp.c_str());
+    throw;
+  }
+  if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+    std::remove(tmp.c_str());
+    throw std::runtime_error("Failed to write output file: " + path);
+  }
+}
+
+}  // namespace
+
+void writeReportFile(const std::string &path, const TraceMeta &meta,
+                     const FindingSet &findings, bool compact) {
+  replaceFile(path, [&](std::ostream &out) {
+    writeReport(out, meta, findings, compact);
+    out << "\n";
+  });
+}
+
+void writeJsonFile(const std::string &path, const json &doc, bool compact) {
+  replaceFile(path, [&](std::ostream &out) {
+    out << (compact ? doc.dump() : doc.dump(2)) << "\n";
+  });
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "analysis.hpp"
+#include "third_party/json.hpp"
+#include "trace.hpp"
+
+struct SeverityCounts {
+  int high = 0;
+  int med = 0;
+  int low = 0;
+
+  void add(const Finding &f);
+  void add(const SeverityCounts &other);
+};
+
+SeverityCounts countSeverities(const FindingSet &findings);
+
+nlohmann::json summaryJson(const SeverityCounts &counts);
+nlohmann::json findingJson(const Finding &f);
+
+// Streams the report for one trace to `out` without building a json DOM.
+// The output is byte-identical to the equivalent nlohmann::json rendered
+// with dump(2), or dump() when `compact`. `count` is only written for
+// findings seen more than once, so reports of traces without repeats keep
+// the original schema.
+void writeReport(std::ostream &out, const TraceMeta &meta, const FindingSet &findings,
+                 bool compact = false);
+
+// writeReport() into a file, replaced only once the whole report is written.
+// Throws std::runtime_error if the file cannot be opened or written, or
+// nlohmann's type_error for evidence that is not valid UTF-8.
+void writeReportFile(const std::string &path, const TraceMeta &meta,
+                     const FindingSet &findings, bool compact = false);
+
+// Writes a small json document such as the batch summary, replacing the
+// file the same way. Throws std::runtime_error if it cannot be written.
+void writeJsonFile(const std::string &path, const nlohmann::json &doc, bool compact = false);
@@ -0,0 +1,584 @@
+#include "rules.hpp"
+
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+
+EventContext::EventContext(const TraceEvent &event, const EndpointClassifier &endpoints)
+    : ev(event),
+      url(event.url),
+      query(url.queryParams()),
+      fragment(url.fragmentParams()),
+      endpoint(endpoints.classify(url)) {}
+
+namespace {
+
+// ---- Per-event rules -------------------------------------------------------
+
+class TokenInQueryRule : public Rule {
+ public:
+  static constexpr RuleInfo kInfo{
+      "TOKEN_IN_QUERY", "HIGH", "HIGH",
+      "Token appears in URL query string",
+      "URLs are logged and can leak via referrer headers.",
+      "Do not put tokens in URLs. Use Authorization header or secure cookies."};
+
+  const RuleInfo &info() const override { return kInfo; }
+  RuleInterest interest() const override {
+    return {.queryKeys = {"access_token", "id_token", "refresh_token"}};
+  }
+  void onEvent(const EventContext &ctx, FindingSet &out) override {
+    out.add(kInfo, ctx.ev.url);
+  }
+};
+
+class TokenInFragmentRule : public Rule {
+ public:
+  static constexpr RuleInfo kInfo{
+      "TOKEN_IN_FRAGMENT", "MED", "MED",
+      "Token appears in URL fragment",
+      "Fragments can be exposed to browser history or extensions.",
+      "Avoid implicit/hybrid flows; use Authorization Code + PKCE."};
+
+  const RuleInfo &info() const override { return kInfo; }
+  RuleInterest interest() const override {
+    return {.fragmentKeys = {"access_token", "id_token"}};
+  }
+  void onEvent(const EventContext &ctx, FindingSet &out) override {
+    out.add(kInfo, ctx.ev.url);
+  }
+};
+
+class CookieMissingSecureRule : public Rule {
+ public:
+  static constexpr RuleInfo kInfo{
+      "COOKIE_MISSING_SECURE", "MED", "MED",
+      "Session cookie missing Secure",
+      "Session cookies without Secure can be sent over HTTP.",
+      "Mark session cookies Secure (and serve over HTTPS)."};
+
+  const RuleInfo &info() const override { return kInfo; }
+  RuleInterest interest() const override { return {.setCookies = true}; }
+  void onCookie(const EventContext &, const ParsedCookie &cookie, std::string_view sc,
+                FindingSet &out) override {
+    if (!isSessionish(cookie) || cookie.has(CookieAttr::Secure)) return;
+    out.add(kInfo, sc);
+  }
+};
+
+class CookieMissingHttpOnlyRule : public Rule {
+ public:
+  static constexpr RuleInfo kInfo{
+      "COOKIE_MISSING_HTTPONLY", "MED", "MED",
+      "Session cookie missing HttpOnly",
+      "Missing HttpOnly increases risk of XSS token theft.",
+      "Mark session cookies HttpOnly to reduce XSS token theft risk."};
+
+  const RuleInfo &info() const override { return kInfo; }
+  RuleInterest interest() const override { return {.setCookies = true}; }
+  void onCookie(const EventContext &, const ParsedCookie &cookie, std::string_view sc,
+                FindingSet &out) override {
+    if (!isSessionish(cookie) || cookie.has(CookieAttr::HttpOnly)) return;
+    out.add(kInfo, sc);
+  }
+};
+
+class SameSiteNoneWithoutSecureRule : public Rule {
+ public:
+  static constexpr RuleInfo kInfo{
+      "SAMESITE_NONE_WITHOUT_SECURE", "HIGH", "HIGH",
+      "SameSite=None cookie without Secure",
+      "Browsers reject SameSite=None cookies without Secure.",
+      "Chrome requires Secure when SameSite=None. Add Secure or change SameSite."};
+
+  const RuleInfo &info() const override { return kInfo; }
+  RuleInterest interest() const override { return {.cookieAttrs = {CookieAttr::SameSite}}; }
+  void onCookie(const EventContext &, const ParsedCookie &cookie, std::string_view sc,
+                FindingSet &out) override {
+    if (!isSameSiteNone(cookie) || cookie.has(CookieAttr::Secure)) return;
+    out.add(kInfo, sc);
+  }
+};
+
+// ---- Cross-event rules -----------------------------------------------------
+//
+// These are evaluated per flow: state is indexed by EventContext::flow and
+// each flow that violates the rule yields its own finding at finish(), in
+// flow order. Evidence names the request that identifies the flow.
+
+// Grows on demand so rules can index state by flow id.
+template <typename T>
+class PerFlow {
+ public:
+  T &operator[](int flow) {
+    if (static_cast<size_t>(flow) >= v_.size()) v_.resize(static_cast<size_t>(flow) + 1);
+    return v_[static_cast<size_t>(flow)];
+  }
+  auto begin() { return v_.begin(); }
+  auto end() { return v_.end(); }
+
+  friend void to_json(nlohmann::json &j, const PerFlow &p) { j = p.v_; }
+  friend void from_json(const nlohmann::json &j, PerFlow &p) { j.get_to(p.v_); }
+
+ private:
+  std::vector<T> v_;
+};
+
+class StateMissingRule : public Rule {
+ public:
+  static constexpr RuleInfo kInfo{
+      "STATE_MISSING", "HIGH", "HIGH",
+      "Callback has code but no state",
+      "State is required to prevent CSRF and code injection.",
+      "Always include and validate state to prevent CSRF/code injection."};
+
+  const RuleInfo &info() const override { return kInfo; }
+  RuleInterest interest() const override {
+    return {.queryKeys = {"code"}, .fragmentKeys = {"code"}};
+  }
+  void onEvent(const EventContext &ctx, FindingSet &) override {
+    if (ctx.role != FlowRole::Callback) return;
+    if (!ctx.query.has("code") && !ctx.fragment.has("code")) return;
+    if (ctx.query.has("state") || ctx.fragment.has("state")) return;
+    auto &evidence = flows_[ctx.flow];
+    if (evidence.empty()) evidence = std::string(ctx.ev.url);
+  }
+  void finish(FindingSet &out) override {
+    for (const auto &callbackUrl : flows_) {
+      if (callbackUrl.empty()) continue;
+      out.add(kInfo, callbackUrl);
+    }
+  }
+  nlohmann::json saveState() const override { return flows_; }
+  void loadState(const nlohmann::json &state) override { state.get_to(flows_); }
+
+ private:
+  PerFlow<std::string> flows_;  // first callback with code and no state
+};
+
+class StateMismatchRule : public Rule {
+ public:
+  static constexpr RuleInfo kInfo{
+      "STATE_MISMATCH", "HIGH", "HIGH",
+      "Callback state does not match authorize state",
+      "Mismatched state indicates possible request forgery.",
+      "Reject callbacks with unexpected state values."};
+
+  const RuleInfo &info() const override { return kInfo; }
+  RuleInterest interest() const override {
+    return {.queryKeys = {"state"}, .fragmentKeys = {"state"}};
+  }
+  void onEvent(const EventContext &ctx, FindingSet &) override {
+    if (ctx.role != FlowRole::Callback || !ctx.flowInfo || !ctx.flowInfo->state) return;
+    auto state = ctx.query.get("state");
+    if (!state) state = ctx.fragment.get("state");
+    if (!state || *state == *ctx.flowInfo->state) return;
+    auto &evidence = flows_[ctx.flow];
+    if (evidence.empty()) evidence = std::string(ctx.ev.url);
+  }
+  void finish(FindingSet &out) override {
+    for (const auto &callbackUrl : flows_) {
+      if (callbackUrl.empty()) continue;
+      out.add(kInfo, callbackUrl);
+    }
+  }
+  nlohmann::json saveState() const override { return flows_; }
+  void loadState(const nlohmann::json &state) override { state.get_to(flows_); }
+
+ private:
+  PerFlow<std::string> flows_;  // first callback whose state differs
+};
+
+class NonceMissingRule : public Rule {
+ public:
+  static constexpr RuleInfo kInfo{
+      "NONCE_MISSING", "HIGH", "HIGH",
+      "Authorize request missing nonce",
+      "OIDC requires nonce to prevent token replay.",
+      "Include a nonce for OIDC flows and validate it in the ID token."};
+
+  const RuleInfo &info() const override { return kInfo; }
+  RuleInterest interest() const override { return {.endpoints = kEndpointAuthorize}; }
+  void onEvent(const EventContext &ctx, FindingSet &) override {
+    if (ctx.role != FlowRole::Authorize) return;
+    State &st = flows_[ctx.flow];
+    if (st.authorizeUrl.empty()) st.authorizeUrl = std::string(ctx.ev.url);
+    if (ctx.query.has("nonce")) st.hasNonce = true;
+    const auto responseType = ctx.query.get("response_type");
+    const auto scope = ctx.query.get("scope");
+    if ((responseType && containsI(*responseType, "id_token")) ||
+        (scope && containsI(*scope, "openid"))) {
+      st.oidc = true;
+    }
+  }
+  void finish(FindingSet &out) override {
+    for (const auto &st : flows_) {
+      if (!st.oidc || st.hasNonce) continue;
+      out.add(kInfo, st.authorizeUrl);
+    }
+  }
+  nlohmann::json saveState() const override { return flows_; }
+  void loadState(const nlohmann::json &state) override { state.get_to(flows_); }
+
+ private:
+  struct State {
+    std::string authorizeUrl;
+    bool oidc = false;
+    bool hasNonce = false;
+
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE(State, authorizeUrl, oidc, hasNonce)
+  };
+  PerFlow<State> flows_;
+};
+
+class PkceMissingRule : public Rule {
+ public:
+  static constexpr RuleInfo kInfo{
+      "PKCE_MISSING", "HIGH", "HIGH",
+      "Authorize request missing PKCE code_challenge",
+      "PKCE mitigates code interception attacks for public clients.",
+      "For public clients, require Authorization Code + PKCE and validate code_verifier at token exchange."};
+
+  const RuleInfo &info() const override { return kInfo; }
+  RuleInterest interest() const override { return {.endpoints = kEndpointAuthorize}; }
+  void onEvent(const EventContext &ctx, FindingSet &) override {
+    if (ctx.role != FlowRole::Authorize) return;
+    State &st = flows_[ctx.flow];
+    if (st.authorizeUrl.empty()) st.authorizeUrl = std::string(ctx.ev.url);
+    if (ctx.query.has("code_challenge")) st.pkceSeen = true;
+  }
+  void finish(FindingSet &out) override {
+    for (const auto &st : flows_) {
+      if (st.authorizeUrl.empty() || st.pkceSeen) continue;
+      out.add(kInfo, st.authorizeUrl);
+    }
+  }
+  nlohmann::json saveState() const override { return flows_; }
+  void loadState(const nlohmann::json &state) override { state.get_to(flows_); }
+
+ private:
+  struct State {
+    std::string authorizeUrl;
+    bool pkceSeen = false;
+
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE(State, authorizeUrl, pkceSeen)
+  };
+  PerFlow<State> flows_;
+};
+
+class PkceNotS256Rule : public Rule {
+ public:
+  static constexpr RuleInfo kInfo{
+      "PKCE_NOT_S256", "MED", "MED",
+      "PKCE code_challenge_method is not S256",
+      "S256 is the recommended PKCE method.",
+      "Prefer S256 for PKCE. Avoid 'plain' except in constrained environments."};
+
+  const RuleInfo &info() const override { return kInfo; }
+  RuleInterest interest() const override { return {.endpoints = kEndpointAuthorize}; }
+  void onEvent(const EventContext &ctx, FindingSet &) override {
+    if (ctx.role != FlowRole::Authorize) return;
+    State &st = flows_[ctx.flow];
+    if (st.authorizeUrl.empty()) st.authorizeUrl = std::string(ctx.ev.url);
+    if (ctx.query.has("code_challenge")) st.pkceSeen = true;
+    if (auto m = ctx.query.get("code_challenge_method")) {
+      if (!equalsI(*m, "s256")) st.notS256 = true;
+    }
+  }
+  void finish(FindingSet &out) override {
+    for (const auto &st : flows_) {
+      if (!st.pkceSeen || !st.notS256) continue;
+      out.add(kInfo, st.authorizeUrl);
+    }
+  }
+  nlohmann::json saveState() const override { return flows_; }
+  void loadState(const nlohmann::json &state) override { state.get_to(flows_); }
+
+ private:
+  struct State {
+    std::string authorizeUrl;
+    bool pkceSeen = false;
+    bool notS256 = false;
+
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE(State, authorizeUrl, pkceSeen, notS256)
+  };
+  PerFlow<State> flows_;
+};
+
+class AuthorizeButNoTokenRule : public Rule {
+ public:
+  static constexpr RuleInfo kInfo{
+      "AUTHORIZE_BUT_NO_TOKEN", "LOW", "LOW",
+      "Authorize flow detected but token exchange not observed",
+      "Missing token exchange may indicate failed flow or sampling gaps.",
+      "If using Authorization Code flow, ensure the client exchanges the code at the token endpoint."};
+
+  const RuleInfo &info() const override { return kInfo; }
+  RuleInterest interest() const override {
+    return {.endpoints = kEndpointAuthorize | kEndpointToken};
+  }
+  void onEvent(const EventContext &ctx, FindingSet &) override {
+    if (ctx.flow < 0) return;
+    State &st = flows_[ctx.flow];
+    if (ctx.role == FlowRole::Authorize && st.authorizeUrl.empty()) {
+      st.authorizeUrl = std::string(ctx.ev.url);
+    }
+    if (ctx.role == FlowRole::Token) st.sawToken = true;
+  }
+  void finish(FindingSet &out) override {
+    for (const auto &st : flows_) {
+      if (st.authorizeUrl.empty() || st.sawToken) continue;
+      out.add(kInfo, st.authorizeUrl);
+    }
+  }
+  nlohmann::json saveState() const override { return flows_; }
+  void loadState(const nlohmann::json &state) override { state.get_to(flows_); }
+
+ private:
+  struct State {
+    std::string authorizeUrl;
+    bool sawToken = false;
+
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE(State, authorizeUrl, sawToken)
+  };
+  PerFlow<State> flows_;
+};
+
+class PkceVerifierMissingRule : public Rule {
+ public:
+  static constexpr RuleInfo kInfo{
+      "PKCE_VERIFIER_MISSING", "MED", "MED",
+      "Token request missing code_verifier",
+      "Missing code_verifier prevents PKCE validation.",
+      "Include code_verifier in token requests for Authorization Code + PKCE."};
+
+  const RuleInfo &info() const override { return kInfo; }
+  RuleInterest interest() const override { return {.endpoints = kEndpointToken}; }
+  void onEvent(const EventContext &ctx, FindingSet &) override {
+    if (ctx.role != FlowRole::Token || !ctx.ev.hasRequestBodyKeys) return;
+    State &st = flows_[ctx.flow];
+    if (st.tokenUrl.empty()) st.tokenUrl = std::string(ctx.ev.url);
+    for (const auto &k : ctx.ev.requestBodyKeys) {
+      if (equalsI(k, "code_verifier")) st.hasVerifier = true;
+    }
+  }
+  void finish(FindingSet &out) override {
+    for (const auto &st : flows_) {
+      if (st.tokenUrl.empty() || st.hasVerifier) continue;
+      out.add(kInfo, st.tokenUrl);
+    }
+  }
+  nlohmann::json saveState() const override { return flows_; }
+  void loadState(const nlohmann::json &state) override { state.get_to(flows_); }
+
+ private:
+  struct State {
+    std::string tokenUrl;  // set once a token request body was observed
+    bool hasVerifier = false;
+
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE(State, tokenUrl, hasVerifier)
+  };
+  PerFlow<State> flows_;
+};
+
+template <typename T>
+std::unique_ptr<Rule> make() {
+  return std::make_unique<T>();
+}
+
+}  // namespace
+
+void RuleRegistry::add(RuleFactory factory) {
+  const auto idx = static_cast<uint16_t>(factories_.size());
+  const RuleInterest in = factory()->interest();
+  factories_.push_back(factory);
+  for (unsigned mask = 1; mask < kEndpointMaskCount; mask++) {
+    if (in.endpoints & mask) endpointRules_[mask].push_back(idx);
+  }
+  for (auto k : in.queryKeys) queryIndex_[std::string(k)].push_back(idx);
+  for (auto k : in.fragmentKeys) fragmentIndex_[std::string(k)].push_back(idx);
+  for (auto k : in.requestBodyKeys) bodyIndex_[std::string(k)].push_back(idx);
+  for (auto side : {HeaderSide::Request, HeaderSide::Response}) {
+    const auto s = static_cast<size_t>(side);
+    for (auto name : side == HeaderSide::Request ? in.requestHeaders : in.responseHeaders) {
+      headerRules_[s][static_cast<size_t>(name)].push_back(idx);
+      headerMask_[s] |= 1u << static_cast<unsigned>(name);
+    }
+  }
+  uint16_t attrs = 0;
+  for (auto a : in.cookieAttrs) attrs |= static_cast<uint16_t>(1u << static_cast<unsigned>(a));
+  if (in.setCookies) cookieRules_.push_back({idx, 0});
+  else if (attrs) cookieRules_.push_back({idx, attrs});
+}
+
+const RuleRegistry &RuleRegistry::builtin() {
+  static const RuleRegistry registry = [] {
+    RuleRegistry r;
+    // Per-event rules, in the order their findings appear for one event.
+    r.add(make<TokenInQueryRule>);
+    r.add(make<TokenInFragmentRule>);
+    r.add(make<CookieMissingSecureRule>);
+    r.add(make<CookieMissingHttpOnlyRule>);
+    r.add(make<SameSiteNoneWithoutSecureRule>);
+    // Cross-event rules, in the order their findings close the report.
+    r.add(make<StateMissingRule>);
+    r.add(make<StateMismatchRule>);
+    r.add(make<NonceMissingRule>);
+    r.add(make<PkceMissingRule>);
+    r.add(make<PkceNotS256Rule>);
+    r.add(make<AuthorizeButNoTokenRule>);
+    r.add(make<PkceVerifierMissingRule>);
+    return r;
+  }();
+  return registry;
+}
+
+RuleEngine::RuleEngine(const RuleRegistry &registry) : registry_(registry) {
+  rules_.reserve(registry.factories_.size());
+  for (auto factory : registry.factories_) rules_.push_back(factory());
+  if (stats_) {
+    for (const auto &rule : rules_) ruleStats_.push_back(&stats_->rule(rule->info()));
+  }
+}
+
+template <typename Call>
+void RuleEngine::run(size_t idx, Call &&call) {
+  if (!stats_) {
+    call(*rules_[idx]);
+    return;
+  }
+  RuleStats &rs = *ruleStats_[idx];
+  const uint64_t before = findings_.occurrences();
+  const auto start = StatsClock::now();
+  call(*rules_[idx]);
+  rs.ns += elapsedNs(start);
+  rs.evaluations++;
+  rs.hits += findings_.occurrences() - before;
+}
+
+void RuleEngine::collectKeys(const ParamView &params, const RuleRegistry::KeyIndex &index) {
+  if (index.empty()) return;
+  params.forEach([&](std::string_view rawKey, std::string_view) {
+    std::string_view key = rawKey;
+    if (rawKey.find_first_of("%+") != std::string_view::npos) {
+      urlDecodeInto(rawKey, scratch_);
+      key = scratch_;
+    }
+    auto it = index.find(key);
+    if (it != index.end()) matched_.insert(matched_.end(), it->second.begin(), it->second.end());
+  });
+}
+
+void RuleEngine::onEvent(const TraceEvent &ev) {
+  if (stats_) {
+    stats_->add(Counter::Events);
+    stats_->countEventType(ev.type);
+  }
+  if (ev.url.empty()) return;
+  if (!stats_) {
+    EventContext ctx(ev, endpoints_);
+    dispatch(ctx);
+    return;
+  }
+  const auto start = StatsClock::now();
+  EventContext ctx(ev, endpoints_);
+  stats_->add(Counter::UrlsParsed);
+  stats_->addTime(Phase::Url, elapsedNs(start));
+  dispatch(ctx);
+}
+
+void RuleEngine::dispatch(EventContext &ctx) {
+  {
+    ScopedTimer timer(stats_, Phase::Correlate);
+    flows_.correlate(ctx);
+  }
+  {
+    ScopedTimer timer(stats_, Phase::Headers);
+    headers_.build(ctx.ev);
+    ctx.headers = &headers_;
+  }
+
+  const auto &byEndpoint = registry_.endpointRules_[ctx.endpoint];
+  matched_.assign(byEndpoint.begin(), byEndpoint.end());
+  collectKeys(ctx.query, registry_.queryIndex_);
+  collectKeys(ctx.fragment, registry_.fragmentIndex_);
+  if (!registry_.bodyIndex_.empty()) {
+    for (auto key : ctx.ev.requestBodyKeys) {
+      auto it = registry_.bodyIndex_.find(key);
+      if (it != registry_.bodyIndex_.end()) {
+        matched_.insert(matched_.end(), it->second.begin(), it->second.end());
+      }
+    }
+  }
+  for (auto side : {HeaderSide::Request, HeaderSide::Response}) {
+    const auto s = static_cast<size_t>(side);
+    uint32_t bits = headers_.present(side) & registry_.headerMask_[s];
+    for (; bits; bits &= bits - 1) {
+      const auto &byHeader = registry_.headerRules_[s][static_cast<size_t>(__builtin_ctz(bits))];
+      matched_.insert(matched_.end(), byHeader.begin(), byHeader.end());
+    }
+  }
+  std::sort(matched_.begin(), matched_.end());
+  matched_.erase(std::unique(matched_.begin(), matched_.end()), matched_.end());
+  for (auto idx : matched_) run(idx, [&](Rule &rule) { rule.onEvent(ctx, findings_); });
+
+  if (registry_.cookieRules_.empty()) return;
+  for (auto sc : headers_.values(HeaderSide::Response, HeaderName::SetCookie)) {
+    const ParsedCookie cookie = parseSetCookie(sc);
+    if (stats_) stats_->add(Counter::CookiesParsed);
+    for (const auto &cr : registry_.cookieRules_) {
+      if (cr.attrs && !(cookie.attrs & cr.attrs)) continue;
+      run(cr.idx, [&](Rule &rule) { rule.onCookie(ctx, cookie, sc, findings_); });
+    }
+  }
+}
+
+void RuleEngine::finish() {
+  ScopedTimer timer(stats_, Phase::Finish);
+  for (size_t i = 0; i < rules_.size(); i++) run(i, [&](Rule &rule) { rule.finish(findings_); });
+}
+
+nlohmann::json RuleEngine::saveState() const {
+  nlohmann::json rules = nlohmann::json::array();
+  for (const auto &rule : rules_) {
+    rules.push_back({{"id", rule->info().id}, {"state", rule->saveState()}});
+  }
+  nlohmann::json findings = nlohmann::json::array();
+  for (const auto &f : findings_) findings.push_back({f.rule->id, f.evidence, f.count});
+  return {{"endpoints", endpoints_.fingerprint()},
+          {"flows", flows_.save()},
+          {"rules", std::move(rules)},
+          {"findings", std::move(findings)}};
+}
+
+void RuleEngine::loadState(const nlohmann::json &state) {
+  try {
+    if (state.at("endpoints").get<uint64_t>() != endpoints_.fingerprint()) {
+      throw std::runtime_error("Engine state was saved with different endpoint profiles.");
+    }
+    const auto &rules = state.at("rules");
+    if (rules.size() != rules_.size()) {
+      throw std::runtime_error("Engine state is from a different rulebook.");
+    }
+    std::unordered_map<std::string_view, const RuleInfo *> byId;
+    for (size_t i = 0; i < rules_.size(); i++) {
+      const RuleInfo &info = rules_[i]->info();
+      if (rules[i].at("id").get<std::string_view>() != info.id) {
+        throw std::runtime_error("Engine state is from a different rulebook.");
+      }
+      rules_[i]->loadState(rules[i].at("state"));
+      byId.emplace(info.id, &info);
+    }
+
+    flows_.load(state.at("flows"));
+
+    findings_ = FindingSet();
+    for (const auto &f : state.at("findings")) {
+      auto it = byId.find(f.at(0).get<std::string_view>());
+      if (it == byId.end()) throw std::runtime_error("Engine state names an unknown rule.");
+      findings_.add(*it->second, f.at(1).get<std::string_view>(), f.at(2).get<uint32_t>());
+    }
+  } catch (const nlohmann::json::exception &e) {
+    throw std::runtime_error(std::string("Invalid engine state: ") + e.what());
+  }
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "cookie.hpp"
+#include "endpoints.hpp"
+#include "findings.hpp"
+#include "flows.hpp"
+#include "headers.hpp"
+#include "stats.hpp"
+#include "string_hash.hpp"
+#include "third_party/json.hpp"
+#include "trace.hpp"
+#include "url.hpp"
+
+// Everything derived from one event, computed once and shared by every rule
+// the event is dispatched to.
+struct EventContext {
+  explicit EventContext(const TraceEvent &event,
+                        const EndpointClassifier &endpoints = endpointClassifier());
+
+  const TraceEvent &ev;
+  UrlView url;
+  ParamView query;
+  ParamView fragment;
+  unsigned endpoint = kEndpointNone;
+
+  // Filled in by the engine before rules run: flow correlation from its
+  // FlowTracker and the event's header index. flowInfo and headers are only
+  // valid for the duration of the dispatch.
+  FlowRole role = FlowRole::None;
+  int flow = -1;
+  const Flow *flowInfo = nullptr;
+  const HeaderIndex *headers = nullptr;
+};
+
+// What makes an event relevant to a rule. Triggers are OR'ed: a rule is
+// dispatched an event if its endpoint class matches or any listed key is
+// present. Rules re-check their exact conditions inside onEvent(). A rule
+// that must notice an absence (PKCE_VERIFIER_MISSING and a token request
+// without code_verifier) asks for the endpoint class rather than a key.
+//
+// Every member has a default so rules can name only the triggers they use.
+struct RuleInterest {
+  unsigned endpoints = kEndpointNone;
+  std::vector<std::string_view> queryKeys = {};
+  std::vector<std::string_view> fragmentKeys = {};
+  // Keys of a form request body (TraceEvent::requestBodyKeys), matched
+  // exactly like query keys.
+  std::vector<std::string_view> requestBodyKeys = {};
+  // Headers whose presence on an event triggers onEvent(); look their values
+  // up in EventContext::headers.
+  std::vector<HeaderName> requestHeaders = {};
+  std::vector<HeaderName> responseHeaders = {};
+  bool setCookies = false;  // onCookie() once per Set-Cookie response header
+  // onCookie() only for Set-Cookie headers carrying one of these attributes;
+  // ignored when setCookies is set.
+  std::vector<CookieAttr> cookieAttrs = {};
+};
+
+// A rule instance lives for one analysis and may keep cross-event state,
+// usually per flow (EventContext::flow).
+class Rule {
+ public:
+  virtual ~Rule() = default;
+  virtual const RuleInfo &info() const = 0;
+  virtual RuleInterest interest() const = 0;
+  virtual void onEvent(const EventContext &, FindingSet &) {}
+  virtual void onCookie(const EventContext &, const ParsedCookie &, std::string_view,
+                        FindingSet &) {}
+  virtual void finish(FindingSet &) {}
+
+  // Cross-event state for checkpoints. Rules that keep none need not
+  // override these.
+  virtual nlohmann::json saveState() const { return nullptr; }
+  virtual void loadState(const nlohmann::json &) {}
+};
+
+using RuleFactory = std::unique_ptr<Rule> (*)();
+
+// Rule factories plus dispatch tables compiled from their interests. Built
+// once and shared read-only by every RuleEngine. Registration order is the
+// order rules see events, which keeps report ordering stable.
+class RuleRegistry {
+ public:
+  void add(RuleFactory factory);
+
+  // The rulebook in docs/rulebook.md.
+  static const RuleRegistry &builtin();
+
+ private:
+  friend class RuleEngine;
+
+  using KeyIndex =
+      std::unordered_map<std::string, std::vector<uint16_t>, StringHash, std::equal_to<>>;
+
+  std::vector<RuleFactory> factories_;
+  // Rules to dispatch for each possible EventContext::endpoint value.
+  std::array<std::vector<uint16_t>, kEndpointMaskCount> endpointRules_;
+  KeyIndex queryIndex_;
+  KeyIndex fragmentIndex_;
+  KeyIndex bodyIndex_;
+  // Rules to dispatch per header, indexed by HeaderSide then HeaderName.
+  std::array<std::array<std::vector<uint16_t>, static_cast<size_t>(HeaderName::kCount)>, 2>
+      headerRules_;
+  std::array<uint32_t, 2> headerMask_{};  // HeaderName bits with any rule, per side
+  // Rules called per Set-Cookie header, with the CookieAttr bits one of
+  // which the cookie must carry (0: every cookie).
+  struct CookieRule {
+    uint16_t idx;
+    uint16_t attrs;
+  };
+  std::vector<CookieRule> cookieRules_;
+};
+
+// Runs one analysis: classifies each event once, then hands it only to the
+// rules whose interest matched.
+class RuleEngine {
+ public:
+  explicit RuleEngine(const RuleRegistry &registry = RuleRegistry::builtin());
+
+  void onEvent(const TraceEvent &ev);
+  // The dispatch half of onEvent(), for callers that classified the event
+  // themselves (the benchmark times the two halves separately). Correlates
+  // the event with a flow, then runs the interested rules.
+  void dispatch(EventContext &ctx);
+  void finish();
+
+  // Everything carried from one event to the next (flow correlation, rule
+  // state and the findings so far), so that a fresh engine given the result
+  // via loadState() continues exactly where this one stopped. Must be called
+  // before finish(). loadState() throws std::runtime_error if the state was
+  // saved by a different rulebook or is malformed.
+  nlohmann::json saveState() const;
+  void loadState(const nlohmann::json &state);
+
+  const FindingSet &findings() const { return findings_; }
+  FindingSet takeFindings() { return std::move(findings_); }
+
+ private:
+  void collectKeys(const ParamView &params, const RuleRegistry::KeyIndex &index);
+  // Calls `call(rule)` for rules_[idx], timed and counted when stats are on.
+  template <typename Call>
+  void run(size_t idx, Call &&call);
+
+  const RuleRegistry &registry_;
+  const EndpointClassifier &endpoints_ = endpointClassifier();
+  std::vector<std::unique_ptr<Rule>> rules_;
+  FlowTracker flows_;
+  HeaderIndex headers_;
+  FindingSet findings_;
+  std::vector<uint16_t> matched_;
+  std::string scratch_;
+  Stats *stats_ = activeStats();  // collector at construction, usually none
+  std::vector<RuleStats *> ruleStats_;  // per rules_ entry when stats_
+};
@@ -0,0 +1,303 @@
+#include "serve.hpp"
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+
+#include "report.hpp"
+#include "rules.hpp"
+#include "trace.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+
+bool writeAll(int fd, std::string_view data) {
+  while (!data.empty()) {
+    ssize_t n = ::write(fd, data.data(), data.size());
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    data.remove_prefix(static_cast<size_t>(n));
+  }
+  return true;
+}
+
+// Splits a file descriptor into lines of at most `maxLine` bytes. A longer
+// line is reported once as TooLong and its bytes are dropped up to the next
+// newline, so one client cannot grow the buffer without bound.
+class LineReader {
+ public:
+  enum class Result { Line, TooLong, Idle, End };
+
+  LineReader(int fd, size_t maxLine) : fd_(fd), maxLine_(maxLine) {}
+
+  // Waits at most `timeoutMs` (-1: forever) for more input; returns Idle if
+  // none arrived in time.
+  Result next(std::string &line, int timeoutMs) {
+    for (;;) {
+      size_t nl = buf_.find('\n', pos_);
+      if (nl != std::string::npos) {
+        const bool dropped = discarding_;
+        discarding_ = false;
+        line.assign(buf_, pos_, nl - pos_);
+        pos_ = nl + 1;
+        if (dropped) continue;
+        if (line.size() > maxLine_) return Result::TooLong;
+        return Result::Line;
+      }
+      buf_.erase(0, pos_);
+      pos_ = 0;
+      if (buf_.size() > maxLine_) {
+        buf_.clear();
+        if (!discarding_) {
+          discarding_ = true;
+          return Result::TooLong;
+        }
+      }
+      pollfd pfd{fd_, POLLIN, 0};
+      int ready = ::poll(&pfd, 1, timeoutMs);
+      if (ready == 0 || (ready < 0 && errno == EINTR)) return Result::Idle;
+      char chunk[65536];
+      ssize_t n = ready < 0 ? -1 : ::read(fd_, chunk, sizeof(chunk));
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) {
+        if (buf_.empty() || discarding_) return Result::End;
+        line.swap(buf_);
+        buf_.clear();
+        return Result::Line;
+      }
+      buf_.append(chunk, static_cast<size_t>(n));
+    }
+  }
+
+ private:
+  int fd_;
+  size_t maxLine_;
+  std::string buf_;
+  size_t pos_ = 0;
+  bool discarding_ = false;  // dropping the rest of an over-long line
+};
+
+class ServeSession {
+ public:
+  ServeSession(int outFd, const ServeOptions &opts) : out_(outFd), opts_(opts) {}
+
+  void handleLine(std::string_view line) {
+    if (line.find_first_not_of(" \t\r") == std::string_view::npos) return;
+    const Clock::time_point now = Clock::now();
+    evictIdle(now);
+
+    // Most lines are single events; an engine for a whole trace is only
+    // built once the parser hands over its first event.
+    std::unique_ptr<Tab> whole;
+    TraceRecord rec;
+    try {
+      rec = readTraceRecord(line, [&](const TraceEvent &ev) {
+        if (!whole) whole = std::make_unique<Tab>();
+        whole->engine.onEvent(ev);
+      });
+    } catch (const std::exception &e) {
+      emit({{"error", e.what()}});
+      return;
+    }
+
+    const int tabId = rec.meta.tabId;
+    if (rec.wholeTrace) {
+      // A complete trace replaces whatever was streamed for the tab so far.
+      tabs_.erase(tabId);
+      if (!whole) whole = std::make_unique<Tab>();
+      flush(tabId, *whole);
+      close(tabId, *whole);
+      return;
+    }
+
+    if (rec.event.type == "END") {
+      auto it = tabs_.find(tabId);
+      if (it == tabs_.end()) return;
+      close(tabId, *it->second);
+      tabs_.erase(it);
+      return;
+    }
+
+    auto &tab = tabs_[tabId];
+    if (!tab) {
+      tab = std::make_unique<Tab>();
+      if (opts_.maxTabs && tabs_.size() > opts_.maxTabs) evictLeastRecent(tabId);
+    }
+    tab->lastActive = now;
+    tab->lastLine = ++lines_;
+    tab->engine.onEvent(rec.event);
+    flush(tabId, *tab);
+  }
+
+  // Called when no input arrived for a while, so idle tabs are still closed
+  // on a quiet connection.
+  void idle() { evictIdle(Clock::now()); }
+
+  void rejectLine() {
+    emit({{"error", "Line longer than " + std::to_string(opts_.maxLineBytes) + " bytes"}});
+  }
+
+  void closeAll() {
+    for (auto &[tabId, tab] : tabs_) close(tabId, *tab);
+    tabs_.clear();
+  }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Tab {
+    RuleEngine engine;
+    SeverityCounts counts;
+    size_t emitted = 0;
+    Clock::time_point lastActive;
+    uint64_t lastLine = 0;
+  };
+
+  // Parse errors quote the offending input, which may not be valid UTF-8;
+  // such bytes are replaced rather than letting dump() throw.
+  void emit(const json &j) {
+    writeAll(out_, j.dump(-1, ' ', false, json::error_handler_t::replace) + "\n");
+  }
+
+  // A tab whose browser went away without sending END would otherwise stay
+  // open for the life of the connection; close it once it has been quiet
+  // for the idle timeout. Swept at most once a second.
+  void evictIdle(Clock::time_point now) {
+    if (opts_.idleTimeout.count() <= 0 || now < nextSweep_) return;
+    nextSweep_ = now + std::chrono::seconds(1);
+    for (auto it = tabs_.begin(); it != tabs_.end();) {
+      if (now - it->second->lastActive < opts_.idleTimeout) {
+        ++it;
+        continue;
+      }
+      close(it->first, *it->second, true);
+      it = tabs_.erase(it);
+    }
+  }
+
+  // Over the tab limit: close the tab that has gone longest without an
+  // event, other than the one just opened.
+  void evictLeastRecent(int keep) {
+    auto victim = tabs_.end();
+    for (auto it = tabs_.begin(); it != tabs_.end(); ++it) {
+      if (it->first == keep) continue;
+      if (victim == tabs_.end() || it->second->lastLine < victim->second->lastLine) victim = it;
+    }
+    if (victim == tabs_.end()) return;
+    close(victim->first, *victim->second, true);
+    tabs_.erase(victim);
+  }
+
+  // Emits findings first seen since the last flush. Repeats of a finding
+  // already sent only bump its count and are not re-emitted.
+  void flush(int tabId, Tab &tab) {
+    const FindingSet &findings = tab.engine.findings();
+    for (; tab.emitted < findings.size(); tab.emitted++) {
+      const Finding &f = findings[tab.emitted];
+      tab.counts.add(f);
+      emit({{"tabId", tabId}, {"finding", findingJson(f)}});
+    }
+  }
+
+  void close(int tabId, Tab &tab, bool evicted = false) {
+    tab.engine.finish();
+    flush(tabId, tab);
+    json done = {{"tabId", tabId}, {"done", true}, {"summary", summaryJson(tab.counts)}};
+    if (evicted) done["evicted"] = true;
+    emit(done);
+  }
+
+  int out_;
+  const ServeOptions &opts_;
+  std::map<int, std::unique_ptr<Tab>> tabs_;
+  uint64_t lines_ = 0;
+  Clock::time_point nextSweep_;
+};
+
+void serveFd(int inFd, int outFd, const ServeOptions &opts) {
+  ServeSession session(outFd, opts);
+  LineReader reader(inFd, opts.maxLineBytes);
+  // With an idle timeout, reads wake up once a second to sweep idle tabs.
+  const int pollMs = opts.idleTimeout.count() > 0 ? 1000 : -1;
+  std::string line;
+  for (;;) {
+    const auto result = reader.next(line, pollMs);
+    if (result == LineReader::Result::End) break;
+    if (result == LineReader::Result::Line) session.handleLine(line);
+    else if (result == LineReader::Result::TooLong) session.rejectLine();
+    else session.idle();
+  }
+  session.closeAll();
+}
+
+int serveSocket(const ServeOptions &opts) {
+  const std::string &path = opts.socketPath;
+  int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener < 0) {
+    std::cerr << "Failed to create socket: " << std::strerror(errno) << "\n";
+    return 1;
+  }
+
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path)) {
+    std::cerr << "Socket path too long: " << path << "\n";
+    ::close(listener);
+    return 1;
+  }
+  std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+  ::unlink(path.c_str());
+  if (::bind(listener, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 ||
+      ::listen(listener, 64) < 0) {
+    std::cerr << "Failed to listen on " << path << ": " << std::strerror(errno) << "\n";
+    ::close(listener);
+    return 1;
+  }
+  std::cerr << "Listening on " << path << "\n";
+
+  for (;;) {
+    int conn = ::accept(listener, nullptr, nullptr);
+    if (conn < 0) {
+      if (errno == EINTR) continue;
+      std::cerr << "accept failed: " << std::strerror(errno) << "\n";
+      break;
+    }
+    // Connection threads are detached, so each takes its own copy of the
+    // options rather than a reference into this frame.
+    std::thread([conn, opts] {
+      serveFd(conn, conn, opts);
+      ::close(conn);
+    }).detach();
+  }
+
+  ::close(listener);
+  ::unlink(path.c_str());
+  return 1;
+}
+
+}  // namespace
+
+int runServe(const ServeOptions &opts) {
+  // A client that disconnects early must not take the daemon down with it.
+  std::signal(SIGPIPE, SIG_IGN);
+  if (opts.socketPath.empty()) {
+    serveFd(STDIN_FILENO, STDOUT_FILENO, opts);
+    return 0;
+  }
+  return serveSocket(opts);
+}
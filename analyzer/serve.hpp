@@ -0,0 +1,29 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+struct ServeOptions {
+  std::string socketPath;  // empty reads stdin and writes stdout
+  std::chrono::seconds idleTimeout{600};  // 0: tabs stay open until END
+  size_t maxTabs = 1024;                  // open tabs per session; 0: no limit
+  size_t maxLineBytes = 64 << 20;         // longer input lines are rejected
+};
+
+// Long-running analyzer. Input is newline-delimited JSON, one record per
+// line:
+//   - an event object with a tabId, fed to that tab's rule engine;
+//   - {"tabId": N, "type": "END"}, which closes tab N;
+//   - a whole trace ({"tabId": N, "events": [...]}), analyzed and closed.
+// Output is newline-delimited JSON written as soon as it is known:
+//   {"tabId": N, "finding": {...}}  when a rule fires,
+//   {"tabId": N, "done": true, "summary": {...}}  when a tab closes,
+//   {"error": "..."}  for a record that cannot be parsed or a line longer
+//                     than maxLineBytes (the rest of that line is skipped).
+// A tab idle for longer than idleTimeout, whether or not other input is
+// arriving, or the least recently active one when a session opens more than
+// maxTabs, is closed early; its done record carries "evicted": true. Open
+// tabs are closed in tabId order at end of input. With a socket path, each
+// connection is an independent session served on its own thread.
+int runServe(const ServeOptions &opts);
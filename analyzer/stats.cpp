@@ -0,0 +1,91 @@
+#include "stats.hpp"
+
+#include <sstream>
+
+namespace {
+
+constexpr std::array<std::string_view, static_cast<size_t>(Counter::kCount)> kCounterNames{
+    "bytesRead", "events", "urlsParsed", "cookiesParsed"};
+constexpr std::array<std::string_view, static_cast<size_t>(Counter::kCount)> kCounterMetrics{
+    "authlens_bytes_read_total", "authlens_events_total", "authlens_urls_parsed_total",
+    "authlens_cookies_parsed_total"};
+constexpr std::array<std::string_view, static_cast<size_t>(Phase::kCount)> kPhaseNames{
+    "read", "parse", "url", "correlate", "headers", "finish", "report"};
+
+double toMs(uint64_t ns) { return static_cast<double>(ns) / 1e6; }
+double toSeconds(uint64_t ns) { return static_cast<double>(ns) / 1e9; }
+
+// Label values may come from the trace (event types).
+std::string label(std::string_view v) {
+  std::string out;
+  for (char c : v) {
+    if (c == '\\' || c == '"') out.push_back('\\');
+    if (c == '\n') out += "\\n";
+    else out.push_back(c);
+  }
+  return out;
+}
+
+}  // namespace
+
+void Stats::countEventType(std::string_view type) {
+  auto it = typeIndex_.find(type);
+  if (it != typeIndex_.end()) {
+    eventTypes_[it->second].second++;
+    return;
+  }
+  typeIndex_.emplace(type, eventTypes_.size());
+  eventTypes_.emplace_back(type, 1);
+}
+
+RuleStats &Stats::rule(const RuleInfo &rule) {
+  for (auto &rs : rules_) {
+    if (rs.id == rule.id) return rs;
+  }
+  return rules_.emplace_back(RuleStats{rule.id});
+}
+
+nlohmann::json Stats::toJson() const {
+  nlohmann::json counters = nlohmann::json::object();
+  for (size_t i = 0; i < counters_.size(); i++) counters[std::string(kCounterNames[i])] = counters_[i];
+  nlohmann::json types = nlohmann::json::object();
+  for (const auto &[name, n] : eventTypes_) types[name] = n;
+  nlohmann::json phases = nlohmann::json::object();
+  for (size_t i = 0; i < phases_.size(); i++) phases[std::string(kPhaseNames[i])] = toMs(phases_[i]);
+  nlohmann::json rules = nlohmann::json::array();
+  for (const auto &rs : rules_) {
+    rules.push_back({{"id", rs.id}, {"evaluations", rs.evaluations}, {"hits", rs.hits},
+                     {"ms", toMs(rs.ns)}});
+  }
+  return {{"counters", counters}, {"eventsByType", types}, {"phasesMs", phases}, {"rules", rules}};
+}
+
+std::string Stats::toPrometheus() const {
+  std::ostringstream out;
+  for (size_t i = 0; i < counters_.size(); i++) {
+    if (static_cast<Counter>(i) == Counter::Events) continue;
+    out << "# TYPE " << kCounterMetrics[i] << " counter\n"
+        << kCounterMetrics[i] << ' ' << counters_[i] << '\n';
+  }
+  out << "# TYPE authlens_events_total counter\n";
+  for (const auto &[name, n] : eventTypes_) {
+    out << "authlens_events_total{type=\"" << label(name) << "\"} " << n << '\n';
+  }
+  out << "# TYPE authlens_phase_seconds_total counter\n";
+  for (size_t i = 0; i < phases_.size(); i++) {
+    out << "authlens_phase_seconds_total{phase=\"" << kPhaseNames[i] << "\"} "
+        << toSeconds(phases_[i]) << '\n';
+  }
+  const std::pair<const char *, uint64_t RuleStats::*> ruleMetrics[] = {
+      {"authlens_rule_evaluations_total", &RuleStats::evaluations},
+      {"authlens_rule_hits_total", &RuleStats::hits}};
+  for (const auto &[metric, field] : ruleMetrics) {
+    out << "# TYPE " << metric << " counter\n";
+    for (const auto &rs : rules_) out << metric << "{rule=\"" << rs.id << "\"} " << rs.*field << '\n';
+  }
+  out << "# TYPE authlens_rule_seconds_total counter\n";
+  for (const auto &rs : rules_) {
+    out << "authlens_rule_seconds_total{rule=\"" << rs.id << "\"} " << toSeconds(rs.ns) << '\n';
+  }
+  return out.str();
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "findings.hpp"
+#include "string_hash.hpp"
+#include "third_party/json.hpp"
+#include "trace.hpp"
+
+// Opt-in instrumentation for `analyze --stats`. The code under measurement
+// asks activeStats() for the collector installed on its thread; when there is
+// none (the default), every hook is a thread-local load and a branch.
+
+enum class Counter : uint8_t { BytesRead, Events, UrlsParsed, CookiesParsed, kCount };
+
+// Wall time spans. Read covers the whole trace read, so it includes the
+// per-event time spent in the event callbacks; Parse is the part of Read
+// outside them (tokenizing and decoding). Url, Correlate and Headers split
+// the per-event work before rules run: URL parsing with endpoint
+// classification, flow correlation, and building the header index.
+enum class Phase : uint8_t { Read, Parse, Url, Correlate, Headers, Finish, Report, kCount };
+
+struct RuleStats {
+  std::string_view id;  // RuleInfo::id, static storage
+  uint64_t evaluations = 0;
+  uint64_t hits = 0;  // finding occurrences reported
+  uint64_t ns = 0;
+};
+
+class Stats {
+ public:
+  void add(Counter c, uint64_t n = 1) { counters_[static_cast<size_t>(c)] += n; }
+  void addTime(Phase p, uint64_t ns) { phases_[static_cast<size_t>(p)] += ns; }
+  void countEventType(std::string_view type);
+  // The entry for `rule`, created on first use. References stay valid for
+  // the collector's lifetime, so engines may cache them.
+  RuleStats &rule(const RuleInfo &rule);
+
+  uint64_t get(Counter c) const { return counters_[static_cast<size_t>(c)]; }
+
+  nlohmann::json toJson() const;
+  // Prometheus text exposition format, authlens_* metrics.
+  std::string toPrometheus() const;
+
+ private:
+  std::array<uint64_t, static_cast<size_t>(Counter::kCount)> counters_{};
+  std::array<uint64_t, static_cast<size_t>(Phase::kCount)> phases_{};
+  std::vector<std::pair<std::string, uint64_t>> eventTypes_;  // first-seen order
+  // Type -> position in eventTypes_.
+  std::unordered_map<std::string, size_t, StringHash, std::equal_to<>> typeIndex_;
+  std::deque<RuleStats> rules_;
+};
+
+namespace stats_detail {
+inline thread_local Stats *active = nullptr;
+}
+
+inline Stats *activeStats() { return stats_detail::active; }
+
+// Installs `stats` as this thread's collector until the scope ends.
+class StatsScope {
+ public:
+  explicit StatsScope(Stats *stats) : prev_(stats_detail::active) { stats_detail::active = stats; }
+  ~StatsScope() { stats_detail::active = prev_; }
+  StatsScope(const StatsScope &) = delete;
+  StatsScope &operator=(const StatsScope &) = delete;
+
+ private:
+  Stats *prev_;
+};
+
+using StatsClock = std::chrono::steady_clock;
+
+inline uint64_t elapsedNs(StatsClock::time_point since) {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(StatsClock::now() - since).count());
+}
+
+// Adds the lifetime of the scope to `phase`; reads no clock when stats are off.
+class ScopedTimer {
+ public:
+  ScopedTimer(Stats *stats, Phase phase) : stats_(stats), phase_(phase) {
+    if (stats_) start_ = StatsClock::now();
+  }
+  explicit ScopedTimer(Phase phase) : ScopedTimer(activeStats(), phase) {}
+  ~ScopedTimer() {
+    if (stats_) stats_->addTime(phase_, elapsedNs(start_));
+  }
+  ScopedTimer(const ScopedTimer &) = delete;
+  ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+ private:
+  Stats *stats_;
+  Phase phase_;
+  StatsClock::time_point start_;
+};
+
+// Times one trace read: Read gets the whole span and Parse the part spent
+// outside the events handed to sinks wrapped with wrap(). Reads no clock
+// when stats are off.
+class ReadTimer {
+ public:
+  explicit ReadTimer(Stats *stats) : stats_(stats) {
+    if (stats_) start_ = StatsClock::now();
+  }
+  ~ReadTimer() {
+    if (!stats_) return;
+    const uint64_t total = elapsedNs(start_);
+    stats_->addTime(Phase::Read, total);
+    stats_->addTime(Phase::Parse, total - std::min(total, sinkNs_));
+  }
+  ReadTimer(const ReadTimer &) = delete;
+  ReadTimer &operator=(const ReadTimer &) = delete;
+
+  // `sink` with its time excluded from Parse. The result refers to `sink`.
+  template <typename Sink>
+  auto wrap(const Sink &sink) {
+    return [this, &sink](const TraceEvent &ev) {
+      if (!stats_) return sink(ev);
+      const auto start = StatsClock::now();
+      sink(ev);
+      sinkNs_ += elapsedNs(start);
+    };
+  }
+
+ private:
+  Stats *stats_;
+  StatsClock::time_point start_;
+  uint64_t sinkNs_ = 0;
+};
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string_view>
+
+// Transparent hash for std::string-keyed unordered containers, so lookups
+// can take a std::string_view without building a std::string. Pair it with
+// std::equal_to<>.
+struct StringHash {
+  using is_transparent = void;
+  size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+};
@@ -0,0 +1,174 @@
+// Check of header-interest dispatch: a probe rule that asks for a request
+// header and a response header must see exactly the events carrying them,
+// with every value indexed, whichever trace shape (a {name, value} list or a
+// name -> value object) and whichever reader (mapped scanner or stream)
+// delivered the headers. A second probe checks the request-body-key and
+// Set-Cookie attribute triggers the same way.
+//
+//   authlens_dispatch_check
+//
+// Prints each mismatch and exits non-zero on failure.
+
+#include <cstdio>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "rules.hpp"
+#include "trace.hpp"
+
+namespace {
+
+constexpr std::string_view kTrace = R"({"version": 1, "tabId": 1, "events": [
+  {"tMs": 1, "type": "HTTP", "url": "https://a.example/",
+   "requestHeaders": [{"name": "AUTHORIZATION", "value": "Bearer x"},
+                      {"name": "Accept", "value": "*/*"},
+                      {"name": "authorization", "value": "Bearer y"}]},
+  {"tMs": 2, "type": "HTTP", "url": "https://a.example/",
+   "requestHeaders": {"Authorization": "Basic z"}},
+  {"tMs": 3, "type": "HTTP", "url": "https://a.example/",
+   "responseHeaders": {"Location": "https://b.example/cb"}},
+  {"tMs": 4, "type": "HTTP", "url": "https://a.example/",
+   "requestHeaders": {"Cookie": "a=1"},
+   "responseHeaders": [{"name": "location", "value": "https://c.example/"}]},
+  {"tMs": 5, "type": "HTTP", "url": "https://a.example/",
+   "requestHeaders": {"Location": "wrong side"},
+   "responseHeaders": {"Authorization": "wrong side", "X-Other": "1"}},
+  {"tMs": 6, "type": "HTTP", "url": "https://a.example/"}
+]})";
+
+// What the probe saw for one event: its tMs, then the indexed values.
+struct Seen {
+  int64_t tMs;
+  std::vector<std::string> authorization;
+  std::vector<std::string> location;
+
+  bool operator==(const Seen &) const = default;
+};
+
+std::vector<Seen> seen;
+
+class ProbeRule : public Rule {
+ public:
+  static constexpr RuleInfo kInfo{"PROBE", "LOW", "LOW", "probe", "", ""};
+
+  const RuleInfo &info() const override { return kInfo; }
+  RuleInterest interest() const override {
+    return {.requestHeaders = {HeaderName::Authorization},
+            .responseHeaders = {HeaderName::Location}};
+  }
+  void onEvent(const EventContext &ctx, FindingSet &) override {
+    Seen s{ctx.ev.tMs, {}, {}};
+    for (auto v : ctx.headers->values(HeaderSide::Request, HeaderName::Authorization)) {
+      s.authorization.emplace_back(v);
+    }
+    for (auto v : ctx.headers->values(HeaderSide::Response, HeaderName::Location)) {
+      s.location.emplace_back(v);
+    }
+    seen.push_back(std::move(s));
+  }
+};
+
+const std::vector<Seen> kExpected = {
+    {1, {"Bearer x", "Bearer y"}, {}},
+    {2, {"Basic z"}, {}},
+    {3, {}, {"https://b.example/cb"}},
+    {4, {}, {"https://c.example/"}},
+};
+
+constexpr std::string_view kBodyCookieTrace = R"({"version": 1, "tabId": 1, "events": [
+  {"tMs": 1, "type": "HTTP", "url": "https://a.example/token",
+   "requestBodyKeys": ["grant_type", "code"]},
+  {"tMs": 2, "type": "HTTP", "url": "https://a.example/token",
+   "requestBodyKeys": ["Grant_Type"]},
+  {"tMs": 3, "type": "HTTP", "url": "https://a.example/",
+   "responseHeaders": [{"name": "Set-Cookie", "value": "a=1; Path=/"},
+                       {"name": "Set-Cookie", "value": "b=2; Partitioned; Secure"}]},
+  {"tMs": 4, "type": "HTTP", "url": "https://a.example/",
+   "responseHeaders": {"Set-Cookie": "c=3; partitioned"}}
+]})";
+
+// Event tMs for onEvent() calls, cookie names for onCookie() calls.
+std::vector<std::string> bodyCookieSeen;
+
+class BodyCookieProbeRule : public Rule {
+ public:
+  static constexpr RuleInfo kInfo{"PROBE_BODY_COOKIE", "LOW", "LOW", "probe", "", ""};
+
+  const RuleInfo &info() const override { return kInfo; }
+  RuleInterest interest() const override {
+    return {.requestBodyKeys = {"grant_type"}, .cookieAttrs = {CookieAttr::Partitioned}};
+  }
+  void onEvent(const EventContext &ctx, FindingSet &) override {
+    bodyCookieSeen.push_back(std::to_string(ctx.ev.tMs));
+  }
+  void onCookie(const EventContext &, const ParsedCookie &cookie, std::string_view,
+                FindingSet &) override {
+    bodyCookieSeen.emplace_back(cookie.name);
+  }
+};
+
+const std::vector<std::string> kBodyCookieExpected = {"1", "b", "c"};
+
+int failures = 0;
+
+void check(const char *reader) {
+  if (seen == kExpected) return;
+  failures++;
+  std::fprintf(stderr, "%s: probe saw %zu events, expected %zu\n", reader, seen.size(),
+               kExpected.size());
+  for (const auto &s : seen) {
+    std::fprintf(stderr, "  tMs=%lld authorization=%zu location=%zu\n",
+                 static_cast<long long>(s.tMs), s.authorization.size(), s.location.size());
+  }
+}
+
+void checkBodyCookie(const char *reader) {
+  if (bodyCookieSeen == kBodyCookieExpected) return;
+  failures++;
+  std::fprintf(stderr, "%s: body/cookie probe saw", reader);
+  for (const auto &s : bodyCookieSeen) std::fprintf(stderr, " %s", s.c_str());
+  std::fprintf(stderr, ", expected 1 b c\n");
+}
+
+}  // namespace
+
+int main() {
+  RuleRegistry registry;
+  registry.add([]() -> std::unique_ptr<Rule> { return std::make_unique<ProbeRule>(); });
+
+  {
+    seen.clear();
+    RuleEngine engine(registry);
+    readTraceBuffer(kTrace, [&](const TraceEvent &ev) { engine.onEvent(ev); });
+    check("scanner");
+  }
+  {
+    seen.clear();
+    RuleEngine engine(registry);
+    std::istringstream in{std::string(kTrace)};
+    readTrace(in, [&](const TraceEvent &ev) { engine.onEvent(ev); });
+    check("stream");
+  }
+
+  RuleRegistry bodyCookie;
+  bodyCookie.add([]() -> std::unique_ptr<Rule> { return std::make_unique<BodyCookieProbeRule>(); });
+  {
+    bodyCookieSeen.clear();
+    RuleEngine engine(bodyCookie);
+    readTraceBuffer(kBodyCookieTrace, [&](const TraceEvent &ev) { engine.onEvent(ev); });
+    checkBodyCookie("scanner");
+  }
+  {
+    bodyCookieSeen.clear();
+    RuleEngine engine(bodyCookie);
+    std::istringstream in{std::string(kBodyCookieTrace)};
+    readTrace(in, [&](const TraceEvent &ev) { engine.onEvent(ev); });
+    checkBodyCookie("stream");
+  }
+
+  std::printf("dispatch: %d mismatches\n", failures);
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,127 @@
+// Differential check for text_kernels: every vector variant available on this
+// machine must agree with the scalar reference, and the URL helpers built on
+// them must agree with straightforward byte-at-a-time implementations.
+//
+//   authlens_kernels_check [iterations]
+//
+// Prints the first mismatch and exits non-zero on failure.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "text_kernels.hpp"
+#include "url.hpp"
+
+namespace {
+
+int failures = 0;
+
+void fail(const char *what, const std::string &input) {
+  if (failures++ < 5) {
+    std::fprintf(stderr, "mismatch in %s for input of %zu bytes\n", what, input.size());
+  }
+}
+
+char lowerRef(char c) { return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + 32) : c; }
+
+std::string decodeRef(std::string_view in) {
+  auto hex = [](char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+  };
+  std::string out;
+  for (size_t i = 0; i < in.size(); i++) {
+    char c = in[i];
+    if (c == '+') c = ' ';
+    else if (c == '%' && i + 2 < in.size() && hex(in[i + 1]) >= 0 && hex(in[i + 2]) >= 0) {
+      c = static_cast<char>(hex(in[i + 1]) * 16 + hex(in[i + 2]));
+      i += 2;
+    }
+    out.push_back(c);
+  }
+  return out;
+}
+
+bool containsRef(std::string_view h, std::string_view n) {
+  auto it = std::search(h.begin(), h.end(), n.begin(), n.end(),
+                        [](char a, char b) { return lowerRef(a) == lowerRef(b); });
+  return n.empty() || it != h.end();
+}
+
+// Random text biased toward the bytes the kernels care about, including the
+// edges of the 'A'..'Z' range and non-ASCII bytes.
+std::string randomText(std::mt19937 &rng, size_t maxLen) {
+  static const std::string alphabet = "%&=;#+ AZaz@[`{09fFgG/._-\x7f\x80\xc1\xda\xff";
+  std::uniform_int_distribution<size_t> len(0, maxLen);
+  std::uniform_int_distribution<int> pick(0, 3);
+  std::uniform_int_distribution<size_t> fromAlphabet(0, alphabet.size() - 1);
+  std::uniform_int_distribution<int> anyByte(0, 255);
+  std::string s(len(rng), '\0');
+  for (auto &c : s) {
+    c = pick(rng) ? alphabet[fromAlphabet(rng)] : static_cast<char>(anyByte(rng));
+  }
+  return s;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const int iterations = argc > 1 ? std::atoi(argv[1]) : 20000;
+  const TextKernels &scalar = *textKernelsFor(KernelLevel::Scalar);
+  std::vector<const TextKernels *> variants;
+  for (auto level : {KernelLevel::Sse2, KernelLevel::Avx2}) {
+    if (const TextKernels *k = textKernelsFor(level)) variants.push_back(k);
+  }
+
+  static const std::string_view sets[] = {"%", "%+", "&=", ";=#", "%&=#", "aA"};
+  std::mt19937 rng(12345);
+  for (int it = 0; it < iterations; it++) {
+    const std::string a = randomText(rng, 200);
+    std::string b = a;
+    for (auto &c : b) {
+      if (rng() % 3 == 0) c = static_cast<char>(c ^ 0x20);
+    }
+
+    for (const TextKernels *k : variants) {
+      for (auto set : sets) {
+        if (k->findAny(a.data(), a.size(), set) != scalar.findAny(a.data(), a.size(), set)) {
+          fail(k->name, a);
+        }
+      }
+      std::string want(a.size(), '\0'), got(a.size(), '\0');
+      scalar.toLower(a.data(), a.size(), want.data());
+      k->toLower(a.data(), a.size(), got.data());
+      if (got != want) fail(k->name, a);
+      if (k->equalsI(a.data(), b.data(), a.size()) != scalar.equalsI(a.data(), b.data(), a.size())) {
+        fail(k->name, a);
+      }
+      for (size_t len : {size_t{1}, size_t{2}, size_t{5}, size_t{17}}) {
+        const std::string_view needle = std::string_view(b).substr(b.size() / 3, len);
+        if (k->findI(a.data(), a.size(), needle) != scalar.findI(a.data(), a.size(), needle)) {
+          fail(k->name, a);
+        }
+      }
+    }
+
+    if (urlDecode(a) != decodeRef(a)) fail("urlDecode", a);
+    const std::string needle = b.substr(b.size() / 2, rng() % 6);
+    if (containsI(a, needle) != containsRef(a, needle)) fail("containsI", a);
+    if (equalsI(a, b) != std::equal(a.begin(), a.end(), b.begin(), b.end(), [](char x, char y) {
+          return lowerRef(x) == lowerRef(y);
+        })) {
+      fail("equalsI", a);
+    }
+  }
+
+  std::printf("kernels: %s", textKernels().name);
+  for (const TextKernels *k : variants) std::printf(" %s", k->name);
+  std::printf(", %d iterations, %d mismatches\n", iterations, failures);
+  return failures == 0 ? 0 : 1;
+}
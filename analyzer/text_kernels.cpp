@@ -0,0 +1,246 @@
+#include "text_kernels.hpp"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define AUTHLENS_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// The SSE2 and scalar bodies are force-inlined into the AVX2 kernels so their
+// tails are VEX-encoded too; calling legacy-SSE code with dirty upper ymm
+// state costs a state transition per call.
+#define AUTHLENS_INLINE inline __attribute__((always_inline))
+
+AUTHLENS_INLINE char lowerAscii(char c) {
+  return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// ---- Scalar ------------------------------------------------------------------
+
+AUTHLENS_INLINE size_t findAnyScalar(const char *p, size_t n, std::string_view set) {
+  for (size_t i = 0; i < n; i++) {
+    for (char c : set) {
+      if (p[i] == c) return i;
+    }
+  }
+  return n;
+}
+
+AUTHLENS_INLINE void toLowerScalar(const char *in, size_t n, char *out) {
+  for (size_t i = 0; i < n; i++) out[i] = lowerAscii(in[i]);
+}
+
+AUTHLENS_INLINE bool equalsIScalar(const char *a, const char *b, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    if (lowerAscii(a[i]) != lowerAscii(b[i])) return false;
+  }
+  return true;
+}
+
+AUTHLENS_INLINE char upperAscii(char c) {
+  return (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
+}
+
+AUTHLENS_INLINE size_t findIScalar(const char *h, size_t n, std::string_view needle) {
+  if (needle.size() > n) return n;
+  for (size_t i = 0; i + needle.size() <= n; i++) {
+    if (equalsIScalar(h + i, needle.data(), needle.size())) return i;
+  }
+  return n;
+}
+
+constexpr TextKernels kScalar{"scalar", findAnyScalar, toLowerScalar, equalsIScalar,
+                              findIScalar};
+
+#ifdef AUTHLENS_X86_KERNELS
+
+// ---- SSE2 (baseline on x86-64) -------------------------------------------------
+//
+// Bytes 'A'..'Z' are found with one signed compare: adding 0x3f maps them to
+// -128..-103, below every other byte.
+
+AUTHLENS_INLINE __m128i upperMask128(__m128i v) {
+  const __m128i shifted = _mm_add_epi8(v, _mm_set1_epi8(0x3f));
+  return _mm_cmplt_epi8(shifted, _mm_set1_epi8(-128 + 26));
+}
+
+AUTHLENS_INLINE __m128i lower128(__m128i v) {
+  return _mm_or_si128(v, _mm_and_si128(upperMask128(v), _mm_set1_epi8(0x20)));
+}
+
+AUTHLENS_INLINE size_t findAnySse2(const char *p, size_t n, std::string_view set) {
+  if (set.empty() || set.size() > 4) return findAnyScalar(p, n, set);
+  __m128i needles[4];
+  for (size_t k = 0; k < 4; k++) needles[k] = _mm_set1_epi8(set[k < set.size() ? k : 0]);
+
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+    __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(v, needles[0]), _mm_cmpeq_epi8(v, needles[1]));
+    hit = _mm_or_si128(hit, _mm_or_si128(_mm_cmpeq_epi8(v, needles[2]),
+                                         _mm_cmpeq_epi8(v, needles[3])));
+    if (int mask = _mm_movemask_epi8(hit)) return i + static_cast<size_t>(__builtin_ctz(mask));
+  }
+  return i + findAnyScalar(p + i, n - i, set);
+}
+
+AUTHLENS_INLINE void toLowerSse2(const char *in, size_t n, char *out) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), lower128(v));
+  }
+  toLowerScalar(in + i, n - i, out + i);
+}
+
+AUTHLENS_INLINE bool equalsISse2(const char *a, const char *b, size_t n) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m128i va = lower128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i)));
+    const __m128i vb = lower128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i)));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) != 0xffff) return false;
+  }
+  return equalsIScalar(a + i, b + i, n - i);
+}
+
+// Candidate positions are those where both the first and the last needle
+// byte match (after folding); only they are compared in full.
+AUTHLENS_INLINE size_t findISse2(const char *h, size_t n, std::string_view needle) {
+  const size_t m = needle.size();
+  if (m == 0 || m > n) return findIScalar(h, n, needle);
+  if (m == 1) {
+    const char cases[2] = {lowerAscii(needle[0]), upperAscii(needle[0])};
+    return findAnySse2(h, n, std::string_view(cases, cases[0] == cases[1] ? 1 : 2));
+  }
+  const __m128i first = _mm_set1_epi8(lowerAscii(needle.front()));
+  const __m128i last = _mm_set1_epi8(lowerAscii(needle.back()));
+
+  size_t i = 0;
+  for (; i + m - 1 + 16 <= n; i += 16) {
+    const __m128i a = lower128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(h + i)));
+    const __m128i b =
+        lower128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(h + i + m - 1)));
+    auto mask = static_cast<unsigned>(
+        _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last))));
+    for (; mask; mask &= mask - 1) {
+      const size_t at = i + static_cast<size_t>(__builtin_ctz(mask));
+      if (equalsIScalar(h + at + 1, needle.data() + 1, m - 2)) return at;
+    }
+  }
+  return i + findIScalar(h + i, n - i, needle);
+}
+
+constexpr TextKernels kSse2{"sse2", findAnySse2, toLowerSse2, equalsISse2, findISse2};
+
+// ---- AVX2 ----------------------------------------------------------------------
+
+#define AUTHLENS_AVX2 __attribute__((target("avx2")))
+
+AUTHLENS_AVX2 AUTHLENS_INLINE __m256i lower256(__m256i v) {
+  const __m256i shifted = _mm256_add_epi8(v, _mm256_set1_epi8(0x3f));
+  const __m256i upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(-128 + 26), shifted);
+  return _mm256_or_si256(v, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+}
+
+AUTHLENS_AVX2 size_t findAnyAvx2(const char *p, size_t n, std::string_view set) {
+  if (set.empty() || set.size() > 4) return findAnyScalar(p, n, set);
+  __m256i needles[4];
+  for (size_t k = 0; k < 4; k++) needles[k] = _mm256_set1_epi8(set[k < set.size() ? k : 0]);
+
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+    __m256i hit =
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, needles[0]), _mm256_cmpeq_epi8(v, needles[1]));
+    hit = _mm256_or_si256(hit, _mm256_or_si256(_mm256_cmpeq_epi8(v, needles[2]),
+                                               _mm256_cmpeq_epi8(v, needles[3])));
+    if (auto mask = static_cast<unsigned>(_mm256_movemask_epi8(hit))) {
+      return i + static_cast<size_t>(__builtin_ctz(mask));
+    }
+  }
+  return i + findAnySse2(p + i, n - i, set);
+}
+
+AUTHLENS_AVX2 void toLowerAvx2(const char *in, size_t n, char *out) {
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), lower256(v));
+  }
+  toLowerSse2(in + i, n - i, out + i);
+}
+
+AUTHLENS_AVX2 bool equalsIAvx2(const char *a, const char *b, size_t n) {
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    const __m256i va = lower256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i)));
+    const __m256i vb = lower256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i)));
+    if (static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb))) != 0xffffffffu) {
+      return false;
+    }
+  }
+  return equalsISse2(a + i, b + i, n - i);
+}
+
+AUTHLENS_AVX2 size_t findIAvx2(const char *h, size_t n, std::string_view needle) {
+  const size_t m = needle.size();
+  if (m == 0 || m > n) return findIScalar(h, n, needle);
+  if (m == 1) {
+    const char cases[2] = {lowerAscii(needle[0]), upperAscii(needle[0])};
+    return findAnyAvx2(h, n, std::string_view(cases, cases[0] == cases[1] ? 1 : 2));
+  }
+  const __m256i first = _mm256_set1_epi8(lowerAscii(needle.front()));
+  const __m256i last = _mm256_set1_epi8(lowerAscii(needle.back()));
+
+  size_t i = 0;
+  for (; i + m - 1 + 32 <= n; i += 32) {
+    const __m256i a = lower256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(h + i)));
+    const __m256i b =
+        lower256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(h + i + m - 1)));
+    auto mask = static_cast<unsigned>(_mm256_movemask_epi8(
+        _mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last))));
+    for (; mask; mask &= mask - 1) {
+      const size_t at = i + static_cast<size_t>(__builtin_ctz(mask));
+      if (equalsIScalar(h + at + 1, needle.data() + 1, m - 2)) return at;
+    }
+  }
+  return i + findISse2(h + i, n - i, needle);
+}
+
+#undef AUTHLENS_AVX2
+
+constexpr TextKernels kAvx2{"avx2", findAnyAvx2, toLowerAvx2, equalsIAvx2, findIAvx2};
+
+#endif  // AUTHLENS_X86_KERNELS
+
+#undef AUTHLENS_INLINE
+
+}  // namespace
+
+const TextKernels *textKernelsFor(KernelLevel level) {
+  switch (level) {
+    case KernelLevel::Scalar:
+      return &kScalar;
+#ifdef AUTHLENS_X86_KERNELS
+    case KernelLevel::Sse2:
+      return &kSse2;
+    case KernelLevel::Avx2:
+      return __builtin_cpu_supports("avx2") ? &kAvx2 : nullptr;
+#else
+    default:
+      return nullptr;
+#endif
+  }
+  return nullptr;
+}
+
+const TextKernels &textKernels() {
+  static const TextKernels *best = [] {
+    for (auto level : {KernelLevel::Avx2, KernelLevel::Sse2}) {
+      if (const TextKernels *k = textKernelsFor(level)) return k;
+    }
+    return &kScalar;
+  }();
+  return *best;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+// Byte-scanning primitives behind the URL and cookie helpers. Each exists as
+// a scalar reference and, on x86-64, SSE2 and AVX2 variants; textKernels()
+// picks the widest one the CPU supports the first time it is called. All
+// variants return identical results for every input.
+struct TextKernels {
+  const char *name;
+  // Offset of the first byte in p[0, n) equal to any byte of `set` (at most
+  // four bytes), or n if there is none.
+  size_t (*findAny)(const char *p, size_t n, std::string_view set);
+  // Writes the ASCII lowercase of in[0, n) to out, which may alias in.
+  void (*toLower)(const char *in, size_t n, char *out);
+  // ASCII case-insensitive equality of a[0, n) and b[0, n).
+  bool (*equalsI)(const char *a, const char *b, size_t n);
+  // Offset of the first ASCII case-insensitive occurrence of `needle` in
+  // h[0, n), or n if there is none. An empty needle is found at 0.
+  size_t (*findI)(const char *h, size_t n, std::string_view needle);
+};
+
+enum class KernelLevel { Scalar, Sse2, Avx2 };
+
+// The kernels for `level`, or nullptr when this build or CPU lacks them.
+const TextKernels *textKernelsFor(KernelLevel level);
+
+// The fastest kernels available, resolved once.
+const TextKernels &textKernels();
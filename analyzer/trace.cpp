@@ -0,0 +1,741 @@
+#include "trace.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include "third_party/json.hpp"
+using json = nlohmann::json;
+
+void TraceEvent::clear() {
+  tMs = 0;
+  type = {};
+  requestId = {};
+  method = {};
+  url = {};
+  initiator = {};
+  status = 0;
+  hasRequestBodyKeys = false;
+  requestBodyKeys.clear();
+  requestHeaders.clear();
+  responseHeaders.clear();
+  owned_.clear();
+}
+
+std::string_view TraceEvent::keep(std::string s) {
+  owned_.push_back(std::make_unique<std::string>(std::move(s)));
+  return *owned_.back();
+}
+
+namespace {
+
+// Integer fields given as non-integral or out-of-range numbers are truncated
+// toward zero and clamped to the int64 range, so untrusted input such as
+// 1e300 cannot reach an undefined conversion. Both readers use this.
+int64_t clampToInt64(double d) {
+  constexpr double kTwo63 = 9223372036854775808.0;
+  if (std::isnan(d)) return 0;
+  if (d >= kTwo63) return std::numeric_limits<int64_t>::max();
+  if (d < -kTwo63) return std::numeric_limits<int64_t>::min();
+  return static_cast<int64_t>(d);
+}
+
+// SAX handler that tracks just enough of the document structure to fill one
+// TraceEvent at a time. Anything outside the known schema is skipped without
+// being materialized.
+class TraceSax {
+ public:
+  // In record mode the root object may itself be an event (one line of
+  // serve input) as well as a trace; root-level event fields fill ev_.
+  TraceSax(TraceMeta &meta, const EventSink &sink, bool recordMode = false)
+      : meta_(meta), sink_(sink), recordMode_(recordMode) {}
+
+  bool null() { return scalar(); }
+  bool boolean(bool v) {
+    if (skip_ == 0 && !stack_.empty() && top() == Ctx::Root && key_ == "truncated") {
+      meta_.truncated = v;
+    }
+    return scalar();
+  }
+  bool number_integer(json::number_integer_t v) { return number(static_cast<int64_t>(v)); }
+  bool number_unsigned(json::number_unsigned_t v) { return number(static_cast<int64_t>(v)); }
+  bool number_float(json::number_float_t v, const json::string_t &) {
+    return number(clampToInt64(v));
+  }
+  bool binary(json::binary_t &) { return scalar(); }
+
+  bool string(json::string_t &v) {
+    if (skip_ > 0 || stack_.empty()) return true;
+    switch (top()) {
+      case Ctx::Root:
+      case Ctx::Event:
+        if (isEvent()) eventString(v);
+        break;
+      case Ctx::BodyKeys:
+        ev_.requestBodyKeys.push_back(ev_.keep(std::move(v)));
+        break;
+      case Ctx::HeaderPair:
+        if (key_ == "name") {
+          pair_.name = ev_.keep(std::move(v));
+          pairHasName_ = true;
+        } else if (key_ == "value") {
+          pair_.value = ev_.keep(std::move(v));
+          pairHasValue_ = true;
+        }
+        break;
+      case Ctx::HeaderMap:
+        headers_->push_back({ev_.keep(key_), ev_.keep(std::move(v))});
+        break;
+      default:
+        break;
+    }
+    return true;
+  }
+
+  bool key(json::string_t &k) {
+    if (skip_ == 0) key_ = std::move(k);
+    return true;
+  }
+
+  bool start_object(std::size_t) {
+    if (skip_ > 0) {
+      skip_++;
+      return true;
+    }
+    if (stack_.empty()) {
+      stack_.push_back(Ctx::Root);
+      return true;
+    }
+    switch (top()) {
+      case Ctx::Events:
+        ev_.clear();
+        stack_.push_back(Ctx::Event);
+        return true;
+      case Ctx::Root:
+      case Ctx::Event:
+        if (isEvent() && (key_ == "responseHeaders" || key_ == "requestHeaders")) {
+          headers_ = key_ == "responseHeaders" ? &ev_.responseHeaders : &ev_.requestHeaders;
+          stack_.push_back(Ctx::HeaderMap);
+          return true;
+        }
+        break;
+      case Ctx::HeaderList:
+        pair_ = Header{};
+        pairHasName_ = pairHasValue_ = false;
+        stack_.push_back(Ctx::HeaderPair);
+        return true;
+      default:
+        break;
+    }
+    skip_ = 1;
+    return true;
+  }
+
+  bool end_object() {
+    if (skip_ > 0) {
+      skip_--;
+      return true;
+    }
+    Ctx done = top();
+    stack_.pop_back();
+    if (done == Ctx::Event) {
+      sink_(ev_);
+    } else if (done == Ctx::HeaderPair) {
+      if (pairHasName_ && pairHasValue_) headers_->push_back(pair_);
+    }
+    return true;
+  }
+
+  bool start_array(std::size_t) {
+    if (skip_ > 0) {
+      skip_++;
+      return true;
+    }
+    if (!stack_.empty()) {
+      if (top() == Ctx::Root && key_ == "events") {
+        sawEvents_ = true;
+        stack_.push_back(Ctx::Events);
+        return true;
+      }
+      if (isEvent()) {
+        if (key_ == "requestBodyKeys") {
+          ev_.hasRequestBodyKeys = true;
+          stack_.push_back(Ctx::BodyKeys);
+          return true;
+        }
+        if (key_ == "responseHeaders" || key_ == "requestHeaders") {
+          headers_ = key_ == "responseHeaders" ? &ev_.responseHeaders : &ev_.requestHeaders;
+          stack_.push_back(Ctx::HeaderList);
+          return true;
+        }
+      }
+    }
+    skip_ = 1;
+    return true;
+  }
+
+  bool end_array() {
+    if (skip_ > 0) {
+      skip_--;
+      return true;
+    }
+    stack_.pop_back();
+    return true;
+  }
+
+  bool parse_error(std::size_t, const std::string &, const nlohmann::detail::exception &e) {
+    error_ = e.what();
+    return false;
+  }
+
+  bool sawEvents() const { return sawEvents_; }
+  TraceEvent &event() { return ev_; }
+  const std::string &error() const { return error_; }
+
+ private:
+  enum class Ctx { Root, Events, Event, BodyKeys, HeaderList, HeaderPair, HeaderMap };
+
+  Ctx top() const { return stack_.back(); }
+
+  // Whether the current container receives event fields.
+  bool isEvent() const {
+    return top() == Ctx::Event || (recordMode_ && top() == Ctx::Root && !sawEvents_);
+  }
+
+  void eventString(json::string_t &v) {
+    if (key_ == "url") ev_.url = ev_.keep(std::move(v));
+    else if (key_ == "type") ev_.type = ev_.keep(std::move(v));
+    else if (key_ == "requestId") ev_.requestId = ev_.keep(std::move(v));
+    else if (key_ == "method") ev_.method = ev_.keep(std::move(v));
+    else if (key_ == "initiator") ev_.initiator = ev_.keep(std::move(v));
+  }
+
+  bool scalar() { return true; }
+
+  bool number(int64_t v) {
+    if (skip_ > 0 || stack_.empty()) return true;
+    if (top() == Ctx::Root) {
+      if (key_ == "version") meta_.version = static_cast<int>(v);
+      else if (key_ == "tabId") meta_.tabId = static_cast<int>(v);
+      else if (key_ == "startedAtMs") meta_.startedAtMs = v;
+      else if (key_ == "droppedEvents") meta_.droppedEvents = static_cast<int>(v);
+    }
+    if (isEvent()) {
+      if (key_ == "tMs") ev_.tMs = v;
+      else if (key_ == "status") ev_.status = static_cast<int>(v);
+    }
+    return true;
+  }
+
+  TraceMeta &meta_;
+  const EventSink &sink_;
+  bool recordMode_ = false;
+  std::vector<Ctx> stack_;
+  int skip_ = 0;
+  std::string key_;
+  TraceEvent ev_;
+  std::vector<Header> *headers_ = nullptr;
+  Header pair_;
+  bool pairHasName_ = false;
+  bool pairHasValue_ = false;
+  bool sawEvents_ = false;
+  std::string error_;
+};
+
+// Recursive-descent reader for the trace schema over a complete in-memory
+// document. Unlike TraceSax it never copies a string that has no escape
+// sequences: event fields are views into the source buffer. Subtrees outside
+// the schema are skipped without being stored, but are validated as fully
+// as the stream reader does, so both accept and reject the same documents.
+class TraceScanner {
+ public:
+  TraceScanner(std::string_view src, const EventSink &sink, TraceResumePoint *resume)
+      : begin_(src.data()), p_(src.data()), end_(src.data() + src.size()), sink_(sink),
+        resume_(resume) {}
+
+  TraceMeta run() {
+    TraceMeta meta;
+    bool sawEvents = false;
+    auto element = [&] {
+      if (peek() == '{') event();
+      else skipValue();
+      mark();
+    };
+    auto onKey = [&](std::string_view key) {
+      char c = peek();
+      if (key == "events" && c == '[') {
+        sawEvents = true;
+        if (resume_) *resume_ = {0, 0, meta};
+        p_++;
+        mark();
+        if (peek() == ']') {
+          p_++;
+        } else {
+          do element();
+          while (more(']'));
+        }
+      } else if (key == "truncated" && (c == 't' || c == 'f')) {
+        meta.truncated = boolean();
+      } else if (isNumberStart(c) && (key == "version" || key == "tabId" ||
+                                      key == "startedAtMs" || key == "droppedEvents")) {
+        const int64_t v = number();
+        if (key == "version") meta.version = static_cast<int>(v);
+        else if (key == "tabId") meta.tabId = static_cast<int>(v);
+        else if (key == "startedAtMs") meta.startedAtMs = v;
+        else meta.droppedEvents = static_cast<int>(v);
+      } else {
+        skipValue();
+      }
+    };
+
+    if (resume_ && resume_->offset > 0) {
+      // Re-enter the events array just past the last event seen before, then
+      // finish the top-level object as usual.
+      if (resume_->offset > static_cast<size_t>(end_ - begin_)) fail("resume point past end");
+      p_ = begin_ + resume_->offset;
+      meta = resume_->meta;
+      sawEvents = true;
+      if (resume_->events == 0 && peek() != ']') element();
+      while (more(']')) element();
+      while (more('}')) member(onKey);
+    } else if (peek() == '{') {
+      object(onKey);
+    } else {
+      skipValue();
+    }
+    if (!sawEvents) throw std::runtime_error("Trace missing events array.");
+    return meta;
+  }
+
+ private:
+  [[noreturn]] void fail(const char *what) const {
+    throw std::runtime_error("Failed to parse JSON: " + std::string(what) + " at byte " +
+                             std::to_string(p_ - begin_));
+  }
+
+  static bool isNumberStart(char c) { return c == '-' || (c >= '0' && c <= '9'); }
+
+  char peek() {
+    while (p_ < end_ && (*p_ == ' ' || *p_ == '\n' || *p_ == '\r' || *p_ == '\t')) p_++;
+    if (p_ == end_) fail("unexpected end of input");
+    return *p_;
+  }
+
+  void expect(char c) {
+    if (peek() != c) fail("unexpected character");
+    p_++;
+  }
+
+  // Scans a string token and returns its raw body; `escaped` reports whether
+  // it needs decoding.
+  std::string_view rawString(bool &escaped) {
+    expect('"');
+    const char *start = p_;
+    escaped = false;
+    for (; p_ < end_; p_++) {
+      unsigned char c = static_cast<unsigned char>(*p_);
+      if (c == '"') {
+        std::string_view raw(start, static_cast<size_t>(p_ - start));
+        p_++;
+        return raw;
+      }
+      if (c == '\\') {
+        escaped = true;
+        p_++;
+      } else if (c < 0x20) {
+        fail("control character in string");
+      } else if (c >= 0x80) {
+        utf8Sequence();
+      }
+    }
+    fail("unterminated string");
+  }
+
+  // Steps over one multi-byte UTF-8 sequence starting at p_, leaving p_ on
+  // its last byte. Rejects what the stream reader rejects: stray
+  // continuation bytes, overlong forms, surrogates and code points past
+  // U+10FFFF.
+  void utf8Sequence() {
+    const auto c = static_cast<unsigned char>(*p_);
+    int len;
+    unsigned char lo = 0x80, hi = 0xBF;  // allowed range of the second byte
+    if (c >= 0xC2 && c <= 0xDF) {
+      len = 2;
+    } else if (c >= 0xE0 && c <= 0xEF) {
+      len = 3;
+      if (c == 0xE0) lo = 0xA0;
+      else if (c == 0xED) hi = 0x9F;
+    } else if (c >= 0xF0 && c <= 0xF4) {
+      len = 4;
+      if (c == 0xF0) lo = 0x90;
+      else if (c == 0xF4) hi = 0x8F;
+    } else {
+      fail("ill-formed UTF-8 byte");
+    }
+    if (end_ - p_ < len) fail("ill-formed UTF-8 byte");
+    for (int i = 1; i < len; i++) {
+      const auto b = static_cast<unsigned char>(p_[i]);
+      if (b < (i == 1 ? lo : 0x80) || b > (i == 1 ? hi : 0xBF)) fail("ill-formed UTF-8 byte");
+    }
+    p_ += len - 1;
+  }
+
+  static int hex4(const char *s) {
+    int v = 0;
+    for (int i = 0; i < 4; i++) {
+      char c = s[i];
+      v <<= 4;
+      if (c >= '0' && c <= '9') v |= c - '0';
+      else if (c >= 'a' && c <= 'f') v |= c - 'a' + 10;
+      else if (c >= 'A' && c <= 'F') v |= c - 'A' + 10;
+      else return -1;
+    }
+    return v;
+  }
+
+  static void appendUtf8(std::string &out, uint32_t cp) {
+    if (cp < 0x80) {
+      out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+      out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+      out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+      out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+      out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else {
+      out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+      out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+  }
+
+  // Decodes the escapes of a raw string body into `out`, or only checks
+  // them when `out` is null.
+  void decodeInto(std::string_view raw, std::string *out) const {
+    if (out) out->reserve(raw.size());
+    for (size_t i = 0; i < raw.size(); i++) {
+      char c = raw[i];
+      if (c != '\\') {
+        if (out) out->push_back(c);
+        continue;
+      }
+      if (++i >= raw.size()) fail("invalid escape");
+      char plain = 0;
+      switch (raw[i]) {
+        case '"': plain = '"'; break;
+        case '\\': plain = '\\'; break;
+        case '/': plain = '/'; break;
+        case 'b': plain = '\b'; break;
+        case 'f': plain = '\f'; break;
+        case 'n': plain = '\n'; break;
+        case 'r': plain = '\r'; break;
+        case 't': plain = '\t'; break;
+        case 'u': {
+          int cp = i + 4 < raw.size() ? hex4(raw.data() + i + 1) : -1;
+          if (cp < 0) fail("invalid \\u escape");
+          i += 4;
+          if (cp >= 0xD800 && cp <= 0xDBFF) {
+            int lo = i + 6 < raw.size() && raw[i + 1] == '\\' && raw[i + 2] == 'u'
+                         ? hex4(raw.data() + i + 3)
+                         : -1;
+            if (lo < 0xDC00 || lo > 0xDFFF) fail("invalid surrogate pair");
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+            i += 6;
+          } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+            fail("invalid surrogate pair");
+          }
+          if (out) appendUtf8(*out, static_cast<uint32_t>(cp));
+          continue;
+        }
+        default:
+          fail("invalid escape");
+      }
+      if (out) out->push_back(plain);
+    }
+  }
+
+  std::string decode(std::string_view raw) const {
+    std::string out;
+    decodeInto(raw, &out);
+    return out;
+  }
+
+  // Steps over a string that is not kept, still checking its escapes.
+  void skipString() {
+    bool escaped;
+    std::string_view raw = rawString(escaped);
+    if (escaped) decodeInto(raw, nullptr);
+  }
+
+  // A string value for the current event: a view into the source when it has
+  // no escapes, otherwise decoded and owned by the event.
+  std::string_view eventString() {
+    bool escaped;
+    std::string_view raw = rawString(escaped);
+    return escaped ? ev_.keep(decode(raw)) : raw;
+  }
+
+  // Keys are compared, not stored, so escaped keys decode into scratch space.
+  std::string_view key() {
+    bool escaped;
+    std::string_view raw = rawString(escaped);
+    if (!escaped) return raw;
+    keyScratch_ = decode(raw);
+    return keyScratch_;
+  }
+
+  // Makes a key returned by key() safe to keep in the current event.
+  std::string_view durableKey(std::string_view k) {
+    if (k.data() >= begin_ && k.data() < end_) return k;
+    return ev_.keep(std::string(k));
+  }
+
+  // Parses a number with the JSON grammar (no leading zeros, digits on both
+  // sides of '.', a signed exponent) and returns it as an integer.
+  int64_t number() {
+    const char *start = p_;
+    auto digits = [&] {
+      if (p_ == end_ || *p_ < '0' || *p_ > '9') fail("invalid number");
+      while (p_ < end_ && *p_ >= '0' && *p_ <= '9') p_++;
+    };
+    if (p_ < end_ && *p_ == '-') p_++;
+    if (p_ < end_ && *p_ == '0') p_++;
+    else digits();
+    bool integral = true;
+    if (p_ < end_ && *p_ == '.') {
+      integral = false;
+      p_++;
+      digits();
+    }
+    if (p_ < end_ && (*p_ == 'e' || *p_ == 'E')) {
+      integral = false;
+      p_++;
+      if (p_ < end_ && (*p_ == '+' || *p_ == '-')) p_++;
+      digits();
+    }
+    if (integral) {
+      int64_t v = 0;
+      auto [ptr, ec] = std::from_chars(start, p_, v);
+      if (ec == std::errc() && ptr == p_) return v;
+      uint64_t u = 0;
+      auto [uptr, uec] = std::from_chars(start, p_, u);
+      if (uec == std::errc() && uptr == p_) return static_cast<int64_t>(u);
+    }
+    std::string tok(start, p_);
+    return clampToInt64(std::strtod(tok.c_str(), nullptr));
+  }
+
+  bool literal(const char *word) {
+    size_t n = std::strlen(word);
+    if (static_cast<size_t>(end_ - p_) < n || std::memcmp(p_, word, n) != 0) {
+      fail("invalid literal");
+    }
+    p_ += n;
+    return true;
+  }
+
+  bool boolean() {
+    if (*p_ == 't') return literal("true");
+    literal("false");
+    return false;
+  }
+
+  // Consumes the separator after a member or element: true for ',', false
+  // for the closing bracket.
+  bool more(char close) {
+    char c = peek();
+    p_++;
+    if (c == close) return false;
+    if (c != ',') fail(close == '}' ? "expected ',' or '}'" : "expected ',' or ']'");
+    return true;
+  }
+
+  template <typename OnKey>
+  void member(OnKey &&onKey) {
+    std::string_view k = key();
+    expect(':');
+    onKey(k);
+  }
+
+  template <typename OnKey>
+  void object(OnKey &&onKey) {
+    expect('{');
+    if (peek() == '}') {
+      p_++;
+      return;
+    }
+    do member(onKey);
+    while (more('}'));
+  }
+
+  template <typename OnElement>
+  void array(OnElement &&onElement) {
+    expect('[');
+    if (peek() == ']') {
+      p_++;
+      return;
+    }
+    do onElement();
+    while (more(']'));
+  }
+
+  // Records the current position as the resume point, counting the event
+  // array element just consumed (if any).
+  void mark() {
+    if (!resume_) return;
+    if (resume_->offset != 0) resume_->events++;
+    resume_->offset = static_cast<size_t>(p_ - begin_);
+  }
+
+  // Skips one value of any shape. Nesting is tracked on an explicit stack
+  // rather than by recursion, so deep input cannot exhaust the call stack.
+  void skipValue() {
+    std::string open;  // '{' or '[' per enclosing container
+    for (;;) {
+      const char c = peek();
+      if (c == '{' || c == '[') {
+        p_++;
+        if (peek() != (c == '{' ? '}' : ']')) {
+          open.push_back(c);
+          if (c == '{') skipMemberKey();
+          continue;
+        }
+        p_++;
+      } else if (c == '"') {
+        skipString();
+      } else if (c == 't') {
+        literal("true");
+      } else if (c == 'f') {
+        literal("false");
+      } else if (c == 'n') {
+        literal("null");
+      } else if (isNumberStart(c)) {
+        number();
+      } else {
+        fail("unexpected character");
+      }
+      // A value is complete: close finished containers until one continues.
+      for (;;) {
+        if (open.empty()) return;
+        const bool inObject = open.back() == '{';
+        if (more(inObject ? '}' : ']')) {
+          if (inObject) skipMemberKey();
+          break;
+        }
+        open.pop_back();
+      }
+    }
+  }
+
+  void skipMemberKey() {
+    key();
+    expect(':');
+  }
+
+  void headerList(std::vector<Header> &out) {
+    array([&] {
+      if (peek() != '{') {
+        skipValue();
+        return;
+      }
+      Header h;
+      bool hasName = false, hasValue = false;
+      object([&](std::string_view k) {
+        if (k == "name" && peek() == '"') {
+          h.name = eventString();
+          hasName = true;
+        } else if (k == "value" && peek() == '"') {
+          h.value = eventString();
+          hasValue = true;
+        } else {
+          skipValue();
+        }
+      });
+      if (hasName && hasValue) out.push_back(h);
+    });
+  }
+
+  void headerMap(std::vector<Header> &out) {
+    object([&](std::string_view k) {
+      if (peek() != '"') {
+        skipValue();
+        return;
+      }
+      std::string_view name = durableKey(k);
+      out.push_back({name, eventString()});
+    });
+  }
+
+  void event() {
+    ev_.clear();
+    object([&](std::string_view k) {
+      char c = peek();
+      if (c == '"') {
+        if (k == "url") ev_.url = eventString();
+        else if (k == "type") ev_.type = eventString();
+        else if (k == "requestId") ev_.requestId = eventString();
+        else if (k == "method") ev_.method = eventString();
+        else if (k == "initiator") ev_.initiator = eventString();
+        else skipValue();
+      } else if (isNumberStart(c) && (k == "tMs" || k == "status")) {
+        int64_t v = number();
+        if (k == "tMs") ev_.tMs = v;
+        else ev_.status = static_cast<int>(v);
+      } else if (c == '[' && k == "requestBodyKeys") {
+        ev_.hasRequestBodyKeys = true;
+        array([&] {
+          if (peek() == '"') ev_.requestBodyKeys.push_back(eventString());
+          else skipValue();
+        });
+      } else if ((c == '[' || c == '{') && (k == "responseHeaders" || k == "requestHeaders")) {
+        auto &headers = k == "responseHeaders" ? ev_.responseHeaders : ev_.requestHeaders;
+        if (c == '[') headerList(headers);
+        else headerMap(headers);
+      } else {
+        skipValue();
+      }
+    });
+    sink_(ev_);
+  }
+
+  const char *begin_;
+  const char *p_;
+  const char *end_;
+  const EventSink &sink_;
+  TraceResumePoint *resume_;
+  TraceEvent ev_;
+  std::string keyScratch_;
+};
+
+}  // namespace
+
+TraceMeta readTrace(std::istream &in, const EventSink &sink) {
+  TraceMeta meta;
+  TraceSax sax(meta, sink);
+  if (!json::sax_parse(in, &sax, json::input_format_t::json, false)) {
+    throw std::runtime_error("Failed to parse JSON: " + sax.error());
+  }
+  if (!sax.sawEvents()) throw std::runtime_error("Trace missing events array.");
+  return meta;
+}
+
+TraceRecord readTraceRecord(std::string_view line, const EventSink &sink) {
+  TraceRecord rec;
+  TraceSax sax(rec.meta, sink, true);
+  if (!json::sax_parse(line.begin(), line.end(), &sax)) {
+    throw std::runtime_error("Failed to parse JSON: " + sax.error());
+  }
+  rec.wholeTrace = sax.sawEvents();
+  if (!rec.wholeTrace) rec.event = std::move(sax.event());
+  return rec;
+}
+
+TraceMeta readTraceBuffer(std::string_view json, const EventSink &sink,
+                          TraceResumePoint *resume) {
+  return TraceScanner(json, sink, resume).run();
+}
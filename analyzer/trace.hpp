@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct Header {
+  std::string_view name;
+  std::string_view value;
+};
+
+// One decoded entry of trace["events"]. Only the fields the analyzer looks at
+// are kept; unknown keys and mistyped values are dropped while parsing.
+//
+// String fields are views. They point either into the caller's input buffer
+// (the mmap path, for strings without escapes) or into strings the event owns
+// itself, so an event is move-only and must not outlive its input buffer.
+struct TraceEvent {
+  TraceEvent() = default;
+  TraceEvent(TraceEvent &&) = default;
+  TraceEvent &operator=(TraceEvent &&) = default;
+  TraceEvent(const TraceEvent &) = delete;
+  TraceEvent &operator=(const TraceEvent &) = delete;
+
+  int64_t tMs = 0;
+  std::string_view type;
+  std::string_view requestId;
+  std::string_view method;
+  std::string_view url;
+  std::string_view initiator;
+  int status = 0;
+  bool hasRequestBodyKeys = false;
+  std::vector<std::string_view> requestBodyKeys;
+  std::vector<Header> requestHeaders;
+  std::vector<Header> responseHeaders;
+
+  // Takes ownership of a decoded string and returns a stable view of it.
+  std::string_view keep(std::string s);
+  void clear();
+
+ private:
+  std::vector<std::unique_ptr<std::string>> owned_;
+};
+
+// Top-level trace fields.
+struct TraceMeta {
+  int version = 0;
+  int tabId = -1;
+  int64_t startedAtMs = 0;  // epoch milliseconds
+  bool truncated = false;
+  int droppedEvents = 0;
+};
+
+using EventSink = std::function<void(const TraceEvent &)>;
+
+// Streams trace JSON from `in`, calling `sink` once per event as soon as the
+// event object closes. The event passed to the sink is reused for the next
+// one, so sinks must copy anything they keep. Throws std::runtime_error on
+// malformed JSON or when the trace has no events array.
+TraceMeta readTrace(std::istream &in, const EventSink &sink);
+
+// Where a scan of a trace document stopped inside its events array: the
+// byte offset just past the last element, how many elements precede it, and
+// the top-level fields that appeared before the array.
+struct TraceResumePoint {
+  size_t offset = 0;  // 0: none, scan from the start
+  uint64_t events = 0;
+  TraceMeta meta;
+};
+
+// Same contract as readTrace, over a complete in-memory document (typically a
+// memory-mapped file). Strings without escape sequences are handed to the
+// sink as views into `json` with no copy; only escaped strings are decoded.
+//
+// With `resume`, a non-zero resume->offset makes the scan start there
+// instead, delivering only the events after it; the caller is responsible
+// for `json` sharing the prefix the point was taken from. On return *resume
+// is advanced to the end of the events array, so a later scan of a longer
+// copy of the document (events appended) can pick up from it.
+TraceMeta readTraceBuffer(std::string_view json, const EventSink &sink,
+                          TraceResumePoint *resume = nullptr);
+
+struct TraceRecord {
+  TraceMeta meta;
+  bool wholeTrace = false;  // the record carried an events array
+  TraceEvent event;         // the record itself when !wholeTrace
+};
+
+// Parses one newline-delimited record: either a whole trace, whose events go
+// to `sink` as they are read, or a single event object that carries its own
+// tabId and is returned in TraceRecord::event. Throws std::runtime_error on
+// malformed JSON.
+TraceRecord readTraceRecord(std::string_view line, const EventSink &sink);
@@ -0,0 +1,115 @@
+#include "url.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+#include "text_kernels.hpp"
+
+// Hex digit values, -1 for anything else.
+static constexpr std::array<int8_t, 256> kHexValue = [] {
+  std::array<int8_t, 256> t{};
+  for (auto &v : t) v = -1;
+  for (int c = '0'; c <= '9'; c++) t[c] = static_cast<int8_t>(c - '0');
+  for (int c = 'a'; c <= 'f'; c++) t[c] = static_cast<int8_t>(c - 'a' + 10);
+  for (int c = 'A'; c <= 'F'; c++) t[c] = static_cast<int8_t>(c - 'A' + 10);
+  return t;
+}();
+
+static int hexValue(char c) { return kHexValue[static_cast<unsigned char>(c)]; }
+
+bool equalsI(std::string_view a, std::string_view b) {
+  return a.size() == b.size() && textKernels().equalsI(a.data(), b.data(), a.size());
+}
+
+bool containsI(std::string_view haystack, std::string_view needle) {
+  if (needle.empty()) return true;
+  if (needle.size() > haystack.size()) return false;
+  return textKernels().findI(haystack.data(), haystack.size(), needle) != haystack.size();
+}
+
+// Decodes the byte at in[i], advancing i past any escape.
+static char decodeAt(std::string_view in, size_t &i) {
+  char c = in[i];
+  if (c == '+') return ' ';
+  if (c == '%' && i + 2 < in.size()) {
+    int hi = hexValue(in[i + 1]);
+    int lo = hexValue(in[i + 2]);
+    if (hi >= 0 && lo >= 0) {
+      i += 2;
+      return static_cast<char>((hi << 4) | lo);
+    }
+  }
+  return c;
+}
+
+void urlDecodeInto(std::string_view in, std::string &out) {
+  out.clear();
+  out.reserve(in.size());
+  // Copy literal runs wholesale; only '%' and '+' need per-byte work.
+  const TextKernels &k = textKernels();
+  size_t i = 0;
+  while (i < in.size()) {
+    const size_t run = k.findAny(in.data() + i, in.size() - i, "%+");
+    out.append(in.data() + i, run);
+    i += run;
+    if (i == in.size()) break;
+    out.push_back(decodeAt(in, i));
+    i++;
+  }
+}
+
+std::string urlDecode(std::string_view in) {
+  std::string out;
+  urlDecodeInto(in, out);
+  return out;
+}
+
+// Compares the decoded form of `encoded` with `plain` without building it.
+static bool decodedEquals(std::string_view encoded, std::string_view plain) {
+  size_t j = 0;
+  for (size_t i = 0; i < encoded.size(); i++, j++) {
+    if (j >= plain.size() || decodeAt(encoded, i) != plain[j]) return false;
+  }
+  return j == plain.size();
+}
+
+std::optional<std::string_view> ParamView::findRaw(std::string_view key) const {
+  std::optional<std::string_view> found;
+  forEach([&](std::string_view k, std::string_view v) {
+    if (decodedEquals(k, key)) found = v;
+  });
+  return found;
+}
+
+bool ParamView::has(std::string_view key) const { return findRaw(key).has_value(); }
+
+std::optional<std::string> ParamView::get(std::string_view key) const {
+  auto v = findRaw(key);
+  if (!v) return std::nullopt;
+  return urlDecode(*v);
+}
+
+UrlView::UrlView(std::string_view url) : full(url) {
+  size_t hash = url.find('#');
+  if (hash != std::string_view::npos) fragment = url.substr(hash + 1);
+
+  size_t qmark = url.find('?');
+  if (qmark != std::string_view::npos) {
+    size_t end = url.find('#', qmark);
+    query = url.substr(qmark + 1, end == std::string_view::npos ? end : end - (qmark + 1));
+  }
+
+  // scheme://host/path, stopping at the first of '?' or '#'.
+  std::string_view rest = url.substr(0, std::min(qmark, hash));
+  size_t colon = rest.find("://");
+  if (colon != std::string_view::npos) {
+    scheme = rest.substr(0, colon);
+    rest.remove_prefix(colon + 3);
+    size_t slash = rest.find('/');
+    host = rest.substr(0, slash);
+    if (slash != std::string_view::npos) path = rest.substr(slash);
+  } else {
+    path = rest;
+  }
+}
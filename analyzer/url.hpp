@@ -0,0 +1,77 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+// ASCII case-insensitive helpers. Neither allocates.
+bool equalsI(std::string_view a, std::string_view b);
+bool containsI(std::string_view haystack, std::string_view needle);
+
+// Decodes application/x-www-form-urlencoded text: '+' becomes a space and
+// %XX escapes with two hex digits become the byte they name. Malformed
+// escapes are kept verbatim.
+std::string urlDecode(std::string_view in);
+// Same, but reuses `out`'s storage.
+void urlDecodeInto(std::string_view in, std::string &out);
+
+// An '&'-separated key[=value] list (a query string or fragment) that is
+// never materialized into a map. Lookups walk the raw slice and compare keys
+// in their decoded form without allocating; only the value that is asked for
+// gets decoded. Repeated keys resolve to the last occurrence.
+class ParamView {
+ public:
+  ParamView() = default;
+  explicit ParamView(std::string_view raw) : raw_(raw) {}
+
+  bool has(std::string_view key) const;
+  // Calls fn(rawKey, rawValue) for every non-empty entry, in order. Both
+  // slices are still percent-encoded.
+  template <typename Fn>
+  void forEach(Fn &&fn) const;
+  std::optional<std::string> get(std::string_view key) const;
+  bool empty() const { return raw_.empty(); }
+  std::string_view raw() const { return raw_; }
+
+ private:
+  // Raw (still encoded) value of the last `key` entry, if any.
+  std::optional<std::string_view> findRaw(std::string_view key) const;
+
+  std::string_view raw_;
+};
+
+template <typename Fn>
+void ParamView::forEach(Fn &&fn) const {
+  size_t i = 0;
+  while (i < raw_.size()) {
+    size_t amp = raw_.find('&', i);
+    std::string_view kv = raw_.substr(i, amp == std::string_view::npos ? amp : amp - i);
+    if (!kv.empty()) {
+      size_t eq = kv.find('=');
+      fn(kv.substr(0, eq), eq == std::string_view::npos ? std::string_view() : kv.substr(eq + 1));
+    }
+    if (amp == std::string_view::npos) break;
+    i = amp + 1;
+  }
+}
+
+// One URL split into slices of the original string. The view must not
+// outlive the string it was built from.
+//
+// query and fragment keep the analyzer's historical definitions: the query
+// starts at the first '?' anywhere in the URL and runs to the next '#', and
+// the fragment is everything after the first '#'. For hash-routed URLs such
+// as "https://app/#/cb?code=x" that means `code` is visible as a query param.
+struct UrlView {
+  explicit UrlView(std::string_view url);
+
+  std::string_view full;
+  std::string_view scheme;
+  std::string_view host;
+  std::string_view path;
+  std::string_view query;
+  std::string_view fragment;
+
+  ParamView queryParams() const { return ParamView(query); }
+  ParamView fragmentParams() const { return ParamView(fragment); }
+};
@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+"""Local stand-in for a browser streaming events to `authlens serve --socket`.
+
+Streams each trace's events as newline-delimited JSON on one connection, one
+tab per trace, then reads findings back until the analyzer closes the
+session. With --expect, checks that the findings for each tab match the
+golden report given for it (same order as the traces) and exits non-zero
+otherwise.
+"""
+
+import argparse
+import json
+import socket
+import sys
+import time
+
+
+def connect(path, timeout_s=5.0):
+    deadline = time.monotonic() + timeout_s
+    while True:
+        sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        try:
+            sock.connect(path)
+            return sock
+        except OSError:
+            sock.close()
+            if time.monotonic() > deadline:
+                raise
+            time.sleep(0.05)
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("socket")
+    parser.add_argument("traces", nargs="+")
+    parser.add_argument("--expect", action="append", default=[])
+    args = parser.parse_args()
+
+    sock = connect(args.socket)
+    lines = []
+    for tab_id, path in enumerate(args.traces, start=1):
+        with open(path) as f:
+            trace = json.load(f)
+        for ev in trace["events"]:
+            lines.append(json.dumps(dict(ev, tabId=tab_id)))
+    # Interleaving is fine: the analyzer keys state by tabId.
+    sock.sendall(("\n".join(lines) + "\n").encode())
+    sock.shutdown(socket.SHUT_WR)
+
+    data = b""
+    while chunk := sock.recv(65536):
+        data += chunk
+    sock.close()
+
+    records = [json.loads(line) for line in data.decode().splitlines() if line]
+    for rec in records:
+        print(json.dumps(rec, sort_keys=True))
+
+    ok = True
+    for tab_id, golden_path in enumerate(args.expect, start=1):
+        with open(golden_path) as f:
+            golden = json.load(f)
+        got = [r["finding"] for r in records if r.get("tabId") == tab_id and "finding" in r]
+        done = [r for r in records if r.get("tabId") == tab_id and r.get("done")]
+        if got != golden["findings"] or not done or done[0]["summary"] != golden["summary"]:
+            print(f"tab {tab_id}: findings differ from {golden_path}", file=sys.stderr)
+            ok = False
+    return 0 if ok else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
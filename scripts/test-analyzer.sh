@@ -5,6 +5,7 @@ ROOT_DIR=$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)
 ANALYZER_BIN="$ROOT_DIR/analyzer/build/authlens"
 TRACE="$ROOT_DIR/samples/traces/sample-trace.json"
 GOLDEN="$ROOT_DIR/samples/reports/sample-report.json"
+GOLDEN_BROKEN="$ROOT_DIR/samples/reports/sample-report-broken.json"
 
 if [[ ! -x "$ANALYZER_BIN" ]]; then
   echo "Analyzer binary not found at $ANALYZER_BIN" >&2
@@ -16,4 +17,246 @@ TMP_FILE=$(mktemp)
 
 diff -u "$GOLDEN" "$TMP_FILE"
 
+# Compact output carries the same document without indentation.
+"$ANALYZER_BIN" analyze "$TRACE" --out "$TMP_FILE" --compact >/dev/null
+python3 -c 'import json, sys; sys.exit(json.load(open(sys.argv[1])) != json.load(open(sys.argv[2])))' \
+  "$GOLDEN" "$TMP_FILE"
+
+# Two logins against different IdPs in one tab, then an injected callback:
+# PKCE is judged per flow and the forged state is still caught.
+"$ANALYZER_BIN" analyze "$ROOT_DIR/samples/fixtures/multi-login-trace.json" --out "$TMP_FILE" >/dev/null
+diff -u "$ROOT_DIR/samples/fixtures/multi-login-report.json" "$TMP_FILE"
+
+# Repeated sightings collapse into one finding with a count; the summary
+# counts distinct findings.
+"$ANALYZER_BIN" analyze "$ROOT_DIR/samples/fixtures/repeats-trace.json" --out "$TMP_FILE" >/dev/null
+diff -u "$ROOT_DIR/samples/fixtures/repeats-report.json" "$TMP_FILE"
+python3 - "$TMP_FILE" <<'PY'
+import json, sys
+report = json.load(open(sys.argv[1]))
+counts = [(f["id"], f.get("count", 1)) for f in report["findings"]]
+assert counts == [("TOKEN_IN_QUERY", 4), ("COOKIE_MISSING_SECURE", 2), ("TOKEN_IN_QUERY", 1)], counts
+assert report["summary"] == {"HIGH": 2, "MED": 1, "LOW": 0}, report["summary"]
+PY
+
 rm -f "$TMP_FILE"
+
+TMP_DIR=$(mktemp -d)
+"$ANALYZER_BIN" analyze-batch "$ROOT_DIR/samples/traces" --out-dir "$TMP_DIR" --jobs 2 >/dev/null
+
+diff -u "$GOLDEN" "$TMP_DIR/sample-trace.report.json"
+diff -u "$GOLDEN_BROKEN" "$TMP_DIR/sample-trace-broken.report.json"
+
+# A trace whose own stem looks like a collision suffix keeps a report of its own.
+COLLIDE_DIR=$(mktemp -d)
+mkdir -p "$COLLIDE_DIR/d1" "$COLLIDE_DIR/d2" "$COLLIDE_DIR/d3"
+cp "$TRACE" "$COLLIDE_DIR/d1/a.json"
+cp "$TRACE" "$COLLIDE_DIR/d2/a.json"
+cp "$ROOT_DIR/samples/traces/sample-trace-broken.json" "$COLLIDE_DIR/d3/a-2.json"
+"$ANALYZER_BIN" analyze-batch "$COLLIDE_DIR/d1/a.json" "$COLLIDE_DIR/d2/a.json" \
+  "$COLLIDE_DIR/d3/a-2.json" --out-dir "$COLLIDE_DIR/out" --jobs 3 >/dev/null
+python3 - "$COLLIDE_DIR/out/summary.json" <<'PY'
+import json, sys
+reports = [t["report"] for t in json.load(open(sys.argv[1]))["traces"]]
+assert len(reports) == 3 and len(set(reports)) == 3, reports
+PY
+diff -u "$GOLDEN_BROKEN" "$(python3 -c 'import json, sys; print(json.load(open(sys.argv[1]))["traces"][2]["report"])' \
+  "$COLLIDE_DIR/out/summary.json")"
+rm -rf "$COLLIDE_DIR"
+
+# A fleet report is the same whether built from traces or from their reports
+# (the batch summary in the report directory is skipped).
+FLEET_DIR=$(mktemp -d)
+"$ANALYZER_BIN" aggregate "$ROOT_DIR/samples/traces" --out "$FLEET_DIR/traces.json" >/dev/null
+"$ANALYZER_BIN" aggregate "$TMP_DIR" --jobs 2 --out "$FLEET_DIR/reports.json" >/dev/null
+diff -u "$FLEET_DIR/traces.json" "$FLEET_DIR/reports.json"
+python3 - "$FLEET_DIR/traces.json" <<'PY'
+import json, sys
+fleet = json.load(open(sys.argv[1]))
+assert fleet["traces"] == 2 and fleet["failed"] == 0 and fleet["failures"] == []
+secure = [g for g in fleet["groups"] if g["id"] == "COOKIE_MISSING_SECURE"]
+assert len(secure) == 1 and secure[0]["traces"] == 2, secure
+assert (secure[0]["firstSeenMs"], secure[0]["lastSeenMs"]) == (1730000000000, 1730000001000), secure
+PY
+rm -rf "$FLEET_DIR"
+
+# Endpoint profiles and discovery documents teach the classifier other IdP
+# paths; without them this Keycloak-style flow has no authorize endpoint.
+cat > "$TMP_DIR/keycloak.json" <<'JSON'
+{"version": 1, "tabId": 7, "startedAtMs": 0, "events": [
+  {"tMs": 1, "type": "HTTP", "url": "https://sso.example.com/realms/main/protocol/openid-connect/auth?client_id=c&response_type=code&scope=openid&state=s1"},
+  {"tMs": 2, "type": "HTTP", "url": "https://app.example.com/cb?code=x&state=s1"}]}
+JSON
+cat > "$TMP_DIR/openid-configuration" <<'JSON'
+{"issuer": "https://sso.example.com/realms/main",
+ "authorization_endpoint": "https://sso.example.com/realms/main/protocol/openid-connect/auth",
+ "token_endpoint": "https://sso.example.com/realms/main/protocol/openid-connect/token"}
+JSON
+"$ANALYZER_BIN" analyze "$TMP_DIR/keycloak.json" --out "$TMP_DIR/kc-plain.json" >/dev/null
+"$ANALYZER_BIN" analyze "$TMP_DIR/keycloak.json" --out "$TMP_DIR/kc-profile.json" \
+  --profile "$ROOT_DIR/analyzer/profiles" >/dev/null
+"$ANALYZER_BIN" analyze "$TMP_DIR/keycloak.json" --out "$TMP_DIR/kc-discovery.json" \
+  --discovery "$TMP_DIR/openid-configuration" >/dev/null
+if grep -q '"PKCE_MISSING"' "$TMP_DIR/kc-plain.json"; then
+  echo "Keycloak authorize endpoint classified without a profile" >&2
+  exit 1
+fi
+grep -q '"PKCE_MISSING"' "$TMP_DIR/kc-profile.json"
+diff -u "$TMP_DIR/kc-profile.json" "$TMP_DIR/kc-discovery.json"
+mkdir -p "$TMP_DIR/no-profiles"
+if "$ANALYZER_BIN" analyze "$TMP_DIR/keycloak.json" --profile "$TMP_DIR/no-profiles" \
+  >/dev/null 2>"$TMP_DIR/no-profiles.err"; then
+  echo "Empty profile directory accepted" >&2
+  exit 1
+fi
+grep -qF "No endpoint profiles matched: $TMP_DIR/no-profiles" "$TMP_DIR/no-profiles.err"
+rm -rf "$TMP_DIR/no-profiles" "$TMP_DIR/no-profiles.err"
+rm -f "$TMP_DIR"/keycloak.json "$TMP_DIR"/openid-configuration "$TMP_DIR"/kc-*.json
+
+# Malformed input is rejected whether the trace is read from a mapping or a
+# pipe, including inside values the analyzer skips: invalid UTF-8, a bad
+# escape, number syntax the JSON grammar forbids, and junk in a nested value.
+BAD_HEAD='{"version": 1, "tabId": 1, "startedAtMs": 0, "events": [{"tMs": 1, "type": "HTTP", '
+printf '%s"url": "https://a.example/\xc0\xaf"}]}' "$BAD_HEAD" >"$TMP_DIR/bad-utf8.json"
+printf '%s"url": "https://a.example/", "extra": "\\x41"}]}' "$BAD_HEAD" >"$TMP_DIR/bad-escape.json"
+printf '%s"url": "https://a.example/", "extra": 01}]}' "$BAD_HEAD" >"$TMP_DIR/bad-zero.json"
+printf '%s"url": "https://a.example/", "extra": 1.}]}' "$BAD_HEAD" >"$TMP_DIR/bad-fraction.json"
+printf '%s"url": "https://a.example/", "extra": [1-2]}]}' "$BAD_HEAD" >"$TMP_DIR/bad-minus.json"
+printf '%s"url": "https://a.example/", "extra": {"a": [1 2]}}]}' "$BAD_HEAD" >"$TMP_DIR/bad-nested.json"
+for bad in "$TMP_DIR"/bad-*.json; do
+  for input in "$bad" /dev/stdin; do
+    if "$ANALYZER_BIN" analyze "$input" --out "$TMP_DIR/bad.report.json" \
+      <"$bad" >/dev/null 2>&1; then
+      echo "Malformed $(basename "$bad") accepted from $input" >&2
+      exit 1
+    fi
+  done
+done
+rm -f "$TMP_DIR"/bad-*.json "$TMP_DIR"/bad.report.json
+
+# Out-of-range numbers in integer fields are clamped the same way by both readers.
+printf '{"version": 1, "tabId": 1, "startedAtMs": 1e300, "events": [{"tMs": -1e300, "type": "HTTP", "url": "https://a.example/?access_token=x"}]}' \
+  >"$TMP_DIR/huge.json"
+"$ANALYZER_BIN" analyze "$TMP_DIR/huge.json" --out "$TMP_DIR/huge-mapped.json" >/dev/null
+"$ANALYZER_BIN" analyze /dev/stdin --out "$TMP_DIR/huge-piped.json" <"$TMP_DIR/huge.json" >/dev/null
+diff -u "$TMP_DIR/huge-mapped.json" "$TMP_DIR/huge-piped.json"
+grep -q '"startedAtMs": 9223372036854775807' "$TMP_DIR/huge-mapped.json"
+rm -f "$TMP_DIR"/huge*.json
+
+# Resuming from a checkpoint of an earlier, shorter export gives the full report.
+python3 - "$ROOT_DIR/samples/traces/sample-trace-broken.json" "$TMP_DIR/partial.json" <<'PY'
+import json, sys
+trace = json.load(open(sys.argv[1]))
+trace["events"] = trace["events"][: len(trace["events"]) // 2]
+json.dump(trace, open(sys.argv[2], "w"), indent=2)
+PY
+python3 -c 'import json, sys; json.dump(json.load(open(sys.argv[1])), open(sys.argv[2], "w"), indent=2)' \
+  "$ROOT_DIR/samples/traces/sample-trace-broken.json" "$TMP_DIR/full.json"
+"$ANALYZER_BIN" analyze "$TMP_DIR/partial.json" --checkpoint "$TMP_DIR/state.json" \
+  --out "$TMP_DIR/partial.report.json" >/dev/null
+"$ANALYZER_BIN" analyze "$TMP_DIR/full.json" --checkpoint "$TMP_DIR/state.json" \
+  --out "$TMP_DIR/resumed.json" | grep -q '^Resumed:'
+diff -u "$GOLDEN_BROKEN" "$TMP_DIR/resumed.json"
+# A checkpoint that cannot be replaced fails the run without leaving its temp file.
+mkdir -p "$TMP_DIR/blocked.json/in-the-way"
+if "$ANALYZER_BIN" analyze "$TMP_DIR/full.json" --checkpoint "$TMP_DIR/blocked.json" \
+  --out "$TMP_DIR/blocked.report.json" >/dev/null 2>&1; then
+  echo "Checkpoint written over a directory" >&2
+  exit 1
+fi
+test ! -e "$TMP_DIR/blocked.json.tmp"
+rm -rf "$TMP_DIR/blocked.json"
+
+# A pack of both samples analyzes to the same reports, one tab at a time.
+"$ANALYZER_BIN" pack "$ROOT_DIR/samples/traces" --out "$TMP_DIR/samples.alpk" >/dev/null
+"$ANALYZER_BIN" analyze "$TMP_DIR/samples.alpk" --tab 123 --out "$TMP_DIR/packed.json" >/dev/null
+diff -u "$GOLDEN" "$TMP_DIR/packed.json"
+"$ANALYZER_BIN" analyze "$TMP_DIR/samples.alpk" --tab 456 --out "$TMP_DIR/packed.json" >/dev/null
+diff -u "$GOLDEN_BROKEN" "$TMP_DIR/packed.json"
+# Each tab of a pack is aggregated as its own trace.
+"$ANALYZER_BIN" aggregate "$ROOT_DIR/samples/traces" --out "$TMP_DIR/fleet-traces.json" >/dev/null
+"$ANALYZER_BIN" aggregate "$TMP_DIR/samples.alpk" --jobs 2 --out "$TMP_DIR/fleet-pack.json" >/dev/null
+diff -u "$TMP_DIR/fleet-traces.json" "$TMP_DIR/fleet-pack.json"
+# Re-packing a pack keeps every tab, and a pack in its own input directory is skipped.
+mkdir -p "$TMP_DIR/repack"
+cp "$TMP_DIR/samples.alpk" "$TMP_DIR/repack/"
+"$ANALYZER_BIN" pack "$TMP_DIR/repack" --out "$TMP_DIR/repack/repacked.alpk" | grep -q '^Packed: 2 traces'
+"$ANALYZER_BIN" pack "$TMP_DIR/repack" --out "$TMP_DIR/repack/repacked.alpk" | grep -q '^Packed: 2 traces'
+"$ANALYZER_BIN" analyze "$TMP_DIR/repack/repacked.alpk" --tab 456 --out "$TMP_DIR/packed.json" >/dev/null
+diff -u "$GOLDEN_BROKEN" "$TMP_DIR/packed.json"
+rm -rf "$TMP_DIR/repack"
+
+# --stats leaves the report alone and counts every event and rule.
+"$ANALYZER_BIN" analyze "$TRACE" --out "$TMP_DIR/stats.report.json" \
+  --stats-out "$TMP_DIR/stats.json" >/dev/null
+diff -u "$GOLDEN" "$TMP_DIR/stats.report.json"
+python3 - "$TRACE" "$TMP_DIR/stats.json" <<'PY'
+import json, sys
+events = json.load(open(sys.argv[1]))["events"]
+stats = json.load(open(sys.argv[2]))
+assert stats["counters"]["events"] == len(events), stats["counters"]
+assert sum(stats["eventsByType"].values()) == len(events)
+assert stats["rules"] and all(r["evaluations"] > 0 for r in stats["rules"])
+phases = stats["phasesMs"]
+assert {"read", "parse", "url", "correlate", "headers"} <= phases.keys(), phases
+assert phases["parse"] <= phases["read"], phases
+PY
+"$ANALYZER_BIN" analyze "$TRACE" --out "$TMP_DIR/stats.report.json" --stats-format prometheus \
+  2>&1 >/dev/null | grep -q '^authlens_rule_evaluations_total{rule="TOKEN_IN_QUERY"} '
+
+# serve closes the least recently active tab once a session has too many open.
+printf '%s\n' '{"tabId": 1, "tMs": 1, "type": "HTTP", "url": "https://a.example/"}' \
+  '{"tabId": 2, "tMs": 2, "type": "HTTP", "url": "https://b.example/"}' \
+  | "$ANALYZER_BIN" serve --max-tabs 1 >"$TMP_DIR/serve.ndjson"
+grep -q '^{"done":true,"evicted":true,.*"tabId":1}$' "$TMP_DIR/serve.ndjson"
+grep -q '^{"done":true,"summary":.*"tabId":2}$' "$TMP_DIR/serve.ndjson"
+
+# An idle tab is evicted while the input is quiet, not only when a line arrives.
+{ printf '%s\n' '{"tabId": 1, "tMs": 1, "type": "HTTP", "url": "https://a.example/"}'; sleep 3; } \
+  | "$ANALYZER_BIN" serve --idle-timeout 1 >"$TMP_DIR/serve.ndjson"
+grep -q '^{"done":true,"evicted":true,.*"tabId":1}$' "$TMP_DIR/serve.ndjson"
+
+# An over-long line is rejected and the session carries on with the next one.
+{ printf '{"tabId": 1, "tMs": 1, "type": "HTTP", "url": "https://a.example/%0200d"}\n' 0
+  printf '%s\n' '{"tabId": 2, "tMs": 2, "type": "HTTP", "url": "https://b.example/"}'; } \
+  | "$ANALYZER_BIN" serve --max-line-bytes 128 >"$TMP_DIR/serve.ndjson"
+grep -q '^{"error":"Line longer than 128 bytes"}$' "$TMP_DIR/serve.ndjson"
+grep -q '^{"done":true,"summary":.*"tabId":2}$' "$TMP_DIR/serve.ndjson"
+if grep -q '"tabId":1' "$TMP_DIR/serve.ndjson"; then
+  echo "Over-long serve line was processed" >&2
+  exit 1
+fi
+
+# A line with invalid UTF-8 gets an error record and the session keeps serving.
+{ printf '{"tabId": 1, "url": "\xff"}\n'
+  printf '%s\n' '{"tabId": 2, "tMs": 2, "type": "HTTP", "url": "https://b.example/"}'; } \
+  | "$ANALYZER_BIN" serve >"$TMP_DIR/serve.ndjson"
+grep -q '^{"error":' "$TMP_DIR/serve.ndjson"
+grep -q '^{"done":true,"summary":.*"tabId":2}$' "$TMP_DIR/serve.ndjson"
+
+rm -rf "$TMP_DIR"
+
+KERNELS_BIN="$ROOT_DIR/analyzer/build/authlens_kernels_check"
+if [[ -x "$KERNELS_BIN" ]]; then
+  "$KERNELS_BIN" >/dev/null
+fi
+
+DISPATCH_BIN="$ROOT_DIR/analyzer/build/authlens_dispatch_check"
+if [[ -x "$DISPATCH_BIN" ]]; then
+  "$DISPATCH_BIN" >/dev/null
+fi
+
+BENCH_BIN="$ROOT_DIR/analyzer/build/authlens_bench"
+if [[ -x "$BENCH_BIN" ]]; then
+  "$BENCH_BIN" --events 2000 --iterations 1 >/dev/null
+fi
+
+TMP_DIR=$(mktemp -d)
+SOCK="$TMP_DIR/authlens.sock"
+"$ANALYZER_BIN" serve --socket "$SOCK" 2>/dev/null &
+SERVE_PID=$!
+trap 'kill "$SERVE_PID" 2>/dev/null || true; rm -rf "$TMP_DIR"' EXIT
+
+python3 "$ROOT_DIR/scripts/serve-client.py" "$SOCK" \
+  "$TRACE" "$ROOT_DIR/samples/traces/sample-trace-broken.json" \
+  --expect "$GOLDEN" --expect "$GOLDEN_BROKEN" >/dev/null